@@ -9,4 +9,15 @@
 #  define likely(x_)   (x_)
 #endif
 
+/* Hint to the processor that we are in a spin-wait loop. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define OSHMPI_CPU_RELAX() __asm__ __volatile__ ("pause" ::: "memory")
+#elif defined(__GNUC__) && (defined(__aarch64__) || defined(__arm__))
+#  define OSHMPI_CPU_RELAX() __asm__ __volatile__ ("yield" ::: "memory")
+#elif defined(__GNUC__) && (defined(__powerpc__) || defined(__ppc__))
+#  define OSHMPI_CPU_RELAX() __asm__ __volatile__ ("or 27,27,27" ::: "memory")
+#else
+#  define OSHMPI_CPU_RELAX() do { } while (0)
+#endif
+
 #endif // COMPILER_UTILS_H
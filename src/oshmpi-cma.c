@@ -0,0 +1,111 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#define _GNU_SOURCE
+
+#include "oshmpi-cma.h"
+
+#ifdef OSHMPI_HAVE_CMA
+
+#include "oshmpi-wait.h"
+
+#include <unistd.h>
+#include <sys/uio.h>
+
+oshmpi_cma_peer_t * oshmpi_cma_peers = NULL;
+
+/* Read by the neighbour at initialization.  It is in the data segment, so
+ * it is mapped even where the start of the etext window is not. */
+static volatile int oshmpi_cma_probe_word = 0x0c3a;
+
+void oshmpi_cma_init(void)
+{
+    oshmpi_cma_peers = NULL;
+
+    /* The same on every PE, so the whole node returns here or nobody does. */
+    if (!oshmpi_getenv_long("OSHMPI_ETEXT_CMA", 1) || shmem_etext_size<=0 || shmem_node_size<2) {
+        return;
+    }
+
+    /* The probe needs the neighbour's pid and base first, so its outcome
+     * cannot join the agreement in oshmpi_initialize, and costs this
+     * allgather and an allreduce over the node. */
+    MPI_Aint   me[2] = { (MPI_Aint)getpid(), (MPI_Aint)shmem_etext_base_ptr };
+    MPI_Aint * all   = malloc(2*shmem_node_size*sizeof(MPI_Aint)); assert(all!=NULL);
+    MPI_Allgather(me, 2, MPI_AINT, all, 2, MPI_AINT, SHMEM_COMM_NODE);
+
+    /* the probe word, unless OSHMPI_ETEXT_WINDOW=section leaves it out */
+    ptrdiff_t probe   = (intptr_t)&oshmpi_cma_probe_word - (intptr_t)shmem_etext_base_ptr;
+    int       in_data = (0<=probe && probe+(ptrdiff_t)sizeof(int)<=shmem_etext_size);
+    size_t    len     = in_data ? sizeof(int) : 1;
+
+    int nbr  = (shmem_node_rank+1) % shmem_node_size;
+    int word = 0;
+    struct iovec local  = { &word, len };
+    struct iovec remote = { (char*)all[2*nbr+1] + (in_data ? probe : 0), len };
+    int ok = (process_vm_readv((pid_t)all[2*nbr], &local, 1, &remote, 1, 0)==(ssize_t)len);
+    if (ok && in_data) {
+        ok = (word==oshmpi_cma_probe_word);
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, SHMEM_COMM_NODE);
+
+    if (ok) {
+        oshmpi_cma_peers = calloc(shmem_world_size, sizeof(oshmpi_cma_peer_t)); assert(oshmpi_cma_peers!=NULL);
+        for (int i=0; i<shmem_node_size; i++) {
+            oshmpi_cma_peers[shmem_smp_rank_list[i]].pid   = (pid_t)all[2*i];
+            oshmpi_cma_peers[shmem_smp_rank_list[i]].etext = (char*)all[2*i+1];
+        }
+    } else {
+        oshmpi_warn("process_vm_readv is not permitted between PEs - static data goes through MPI");
+    }
+    free(all);
+
+#if SHMEM_DEBUG>0
+    if (shmem_world_rank==0) {
+        printf("OSHMPI cross-memory attach for static data is %s\n", ok ? "enabled" : "disabled");
+    }
+#endif
+}
+
+void oshmpi_cma_finalize(void)
+{
+    free(oshmpi_cma_peers);
+    oshmpi_cma_peers = NULL;
+}
+
+int oshmpi_cma_put(shmem_offset_t offset, const void *source, size_t bytes, int pe)
+{
+    const oshmpi_cma_peer_t * p = &oshmpi_cma_peers[pe];
+    const char * s = source;
+
+    while (bytes>0) {
+        struct iovec local  = { (void*)s, bytes };
+        struct iovec remote = { p->etext + offset, bytes };
+        ssize_t n = process_vm_writev(p->pid, &local, 1, &remote, 1, 0);
+        if (n<=0) return 1;
+        s      += n;
+        offset += n;
+        bytes  -= n;
+    }
+    if (shmem_world_is_smp)
+        oshmpi_wait_wake(pe);
+    return 0;
+}
+
+int oshmpi_cma_get(void *target, shmem_offset_t offset, size_t bytes, int pe)
+{
+    const oshmpi_cma_peer_t * p = &oshmpi_cma_peers[pe];
+    char * t = target;
+
+    while (bytes>0) {
+        struct iovec local  = { t, bytes };
+        struct iovec remote = { p->etext + offset, bytes };
+        ssize_t n = process_vm_readv(p->pid, &local, 1, &remote, 1, 0);
+        if (n<=0) return 1;
+        t      += n;
+        offset += n;
+        bytes  -= n;
+    }
+    return 0;
+}
+
+#endif /* OSHMPI_HAVE_CMA */
@@ -0,0 +1,83 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#ifndef OSHMPI_CMA_H
+#define OSHMPI_CMA_H
+
+#include "shmem-internals.h"
+
+/* Intranode puts and gets of static data by cross-memory attach.
+ *
+ * The symmetric heap of a PE on the same node is mapped into our address
+ * space, but its data and bss are not, so puts and gets of global
+ * variables went through the etext window even between neighbours.  On
+ * Linux, process_vm_writev and process_vm_readv copy between two address
+ * spaces in one system call, with no intermediate buffer.
+ *
+ * At initialization the PEs of a node exchange their pids and the bases of
+ * their static data, which differ with ASLR, and each one reads a byte
+ * from a neighbour.  That fails where ptrace is restricted (Yama
+ * ptrace_scope=1 with unrelated processes, or a seccomp filter), and then
+ * the node keeps using MPI.  OSHMPI_ETEXT_CMA=0 disables this.  Atomics
+ * always go through MPI, since cross-memory attach is only a copy. */
+
+#if defined(ENABLE_SMP_OPTIMIZATIONS) && defined(HAVE_LINUX) && defined(HAVE_PROCESS_VM_READV)
+#define OSHMPI_HAVE_CMA 1
+#endif
+
+#ifdef OSHMPI_HAVE_CMA
+
+#include <sys/types.h>
+
+typedef struct oshmpi_cma_peer_s
+{
+    pid_t  pid;   /* 0 if the PE is not reachable */
+    char * etext; /* base of its static data */
+} oshmpi_cma_peer_t;
+
+/* by world rank, NULL if nothing is reachable */
+extern oshmpi_cma_peer_t * oshmpi_cma_peers;
+
+/* Collective, after the base of the static data is known. */
+void oshmpi_cma_init(void);
+void oshmpi_cma_finalize(void);
+
+/* Returns 1 and the offset in the etext window if addr is static data that
+ * pe can be reached at by cross-memory attach, and 0 otherwise.  This does
+ * not create the window if OSHMPI_ETEXT_WINDOW=lazy. */
+static inline int oshmpi_cma_offset(const void * addr, int pe, shmem_offset_t * offset)
+{
+    if ( likely(oshmpi_cma_peers==NULL || oshmpi_cma_peers[pe].pid==0) ) return 0;
+    ptrdiff_t o = (intptr_t)addr - (intptr_t)shmem_etext_base_ptr;
+    if (o<0 || o>=shmem_etext_size) return 0;
+    *offset = o;
+    return 1;
+}
+
+/* These return 0 once all bytes are copied, and nonzero if the kernel
+ * refused, in which case the caller uses MPI instead. */
+int oshmpi_cma_put(shmem_offset_t offset, const void *source, size_t bytes, int pe);
+int oshmpi_cma_get(void *target, shmem_offset_t offset, size_t bytes, int pe);
+
+#else
+
+static inline void oshmpi_cma_init(void) {}
+static inline void oshmpi_cma_finalize(void) {}
+static inline int oshmpi_cma_offset(const void * addr, int pe, shmem_offset_t * offset)
+{
+    (void)addr; (void)pe; (void)offset;
+    return 0;
+}
+static inline int oshmpi_cma_put(shmem_offset_t offset, const void *source, size_t bytes, int pe)
+{
+    (void)offset; (void)source; (void)bytes; (void)pe;
+    return 1;
+}
+static inline int oshmpi_cma_get(void *target, shmem_offset_t offset, size_t bytes, int pe)
+{
+    (void)target; (void)offset; (void)bytes; (void)pe;
+    return 1;
+}
+
+#endif /* OSHMPI_HAVE_CMA */
+
+#endif /* OSHMPI_CMA_H */
@@ -0,0 +1,122 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#include "oshmpi-copy.h"
+
+#include <unistd.h>
+#include <pthread.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+size_t oshmpi_copy_nt_threshold = SIZE_MAX;
+
+static size_t oshmpi_copy_thread_threshold;
+static int    oshmpi_copy_threads;
+
+#define OSHMPI_COPY_THREADS_MAX 64
+
+void oshmpi_copy_init(void)
+{
+    long llc = 0;
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+    llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+    if (llc<=0) llc = 8*1024*1024;
+
+    long nt      = oshmpi_getenv_long("OSHMPI_COPY_NT_THRESHOLD", llc);
+    long threads = oshmpi_getenv_long("OSHMPI_COPY_THREADS", 1);
+    long tt      = oshmpi_getenv_long("OSHMPI_COPY_THREAD_THRESHOLD", 32000000);
+
+    oshmpi_copy_nt_threshold     = (nt>0) ? (size_t)nt : SIZE_MAX;
+    oshmpi_copy_threads          = (threads<1) ? 1 : (threads>OSHMPI_COPY_THREADS_MAX) ? OSHMPI_COPY_THREADS_MAX : (int)threads;
+    oshmpi_copy_thread_threshold = (tt>0) ? (size_t)tt : SIZE_MAX;
+
+    /* thread splitting is also done in oshmpi_copy_large */
+    if (oshmpi_copy_threads>1 && oshmpi_copy_thread_threshold<oshmpi_copy_nt_threshold)
+        oshmpi_copy_nt_threshold = oshmpi_copy_thread_threshold;
+}
+
+static void oshmpi_copy_nt(void *dst, const void *src, size_t n)
+{
+#if defined(__SSE2__)
+    char *       d = dst;
+    const char * s = src;
+
+    /* head, up to 16-byte alignment of the destination */
+    size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+    if (head>n) head = n;
+    memcpy(d, s, head);
+    d += head; s += head; n -= head;
+
+    size_t body = n & ~(size_t)63;
+    for (size_t i=0; i<body; i+=64) {
+        __m128i x0 = _mm_loadu_si128((const __m128i*)(s+i));
+        __m128i x1 = _mm_loadu_si128((const __m128i*)(s+i+16));
+        __m128i x2 = _mm_loadu_si128((const __m128i*)(s+i+32));
+        __m128i x3 = _mm_loadu_si128((const __m128i*)(s+i+48));
+        _mm_stream_si128((__m128i*)(d+i),    x0);
+        _mm_stream_si128((__m128i*)(d+i+16), x1);
+        _mm_stream_si128((__m128i*)(d+i+32), x2);
+        _mm_stream_si128((__m128i*)(d+i+48), x3);
+    }
+
+    /* tail */
+    memcpy(d+body, s+body, n-body);
+
+    /* streaming stores are weakly ordered, so they must be fenced before a
+     * flag or wake-up can make them visible to another PE */
+    _mm_sfence();
+#else
+    memcpy(dst, src, n);
+#endif
+}
+
+typedef struct oshmpi_copy_part_s
+{
+    void *       dst;
+    const void * src;
+    size_t       n;
+} oshmpi_copy_part_t;
+
+static void * oshmpi_copy_thread(void * arg)
+{
+    oshmpi_copy_part_t * p = arg;
+    oshmpi_copy_nt(p->dst, p->src, p->n);
+    return NULL;
+}
+
+void oshmpi_copy_large(void *dst, const void *src, size_t n)
+{
+    int nt = oshmpi_copy_threads;
+    if (nt<2 || n<oshmpi_copy_thread_threshold) {
+        oshmpi_copy_nt(dst, src, n);
+        return;
+    }
+
+    /* Helper threads are created per copy, which costs tens of microseconds
+     * against the milliseconds that a copy above the threshold takes. */
+    pthread_t          tid[OSHMPI_COPY_THREADS_MAX];
+    oshmpi_copy_part_t part[OSHMPI_COPY_THREADS_MAX];
+    size_t             chunk = ((n/nt) + 63) & ~(size_t)63; /* whole cache lines */
+
+    int created = 0;
+    for (int i=0; i<nt; i++) {
+        size_t off = (size_t)i*chunk;
+        part[i].dst = (char*)dst + off;
+        part[i].src = (const char*)src + off;
+        part[i].n   = (off>=n) ? 0 : (n-off<chunk) ? n-off : chunk;
+    }
+    for (int i=1; i<nt; i++) {
+        if (part[i].n==0) break;
+        if (pthread_create(&tid[i], NULL, oshmpi_copy_thread, &part[i])!=0) {
+            /* no threads available, so do the rest here */
+            for (int j=i; j<nt; j++)
+                oshmpi_copy_nt(part[j].dst, part[j].src, part[j].n);
+            break;
+        }
+        created = i;
+    }
+    oshmpi_copy_nt(part[0].dst, part[0].src, part[0].n);
+    for (int i=1; i<=created; i++)
+        pthread_join(tid[i], NULL);
+}
@@ -0,0 +1,33 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#ifndef OSHMPI_COPY_H
+#define OSHMPI_COPY_H
+
+#include "shmem-internals.h"
+
+/* Copy engine for the intranode load-store paths.
+ *
+ * Copies smaller than OSHMPI_COPY_NT_THRESHOLD (default: the size of the
+ * last-level cache) are a plain memcpy.  Larger ones use non-temporal
+ * stores where the compiler supports them, so that a copy into a peer's
+ * heap does not evict our own working set, with the unaligned head and
+ * tail done by memcpy.  Copies of at least OSHMPI_COPY_THREAD_THRESHOLD
+ * bytes are split across OSHMPI_COPY_THREADS threads (default 1, i.e.
+ * no helper threads), since one core cannot saturate memory bandwidth. */
+
+extern size_t oshmpi_copy_nt_threshold;
+
+void oshmpi_copy_init(void);
+
+void oshmpi_copy_large(void *dst, const void *src, size_t n);
+
+static inline void oshmpi_copy(void *dst, const void *src, size_t n)
+{
+    if ( likely(n<oshmpi_copy_nt_threshold) ) {
+        memcpy(dst, src, n);
+    } else {
+        oshmpi_copy_large(dst, src, n);
+    }
+}
+
+#endif /* OSHMPI_COPY_H */
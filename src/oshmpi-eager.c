@@ -0,0 +1,96 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#include "oshmpi-eager.h"
+#include "oshmpi-cma.h"
+
+size_t oshmpi_eager_threshold;
+
+static char *        oshmpi_eager_pool;
+static MPI_Request * oshmpi_eager_reqs;
+static int           oshmpi_eager_nslots;
+static int           oshmpi_eager_head;    /* next slot to use */
+static int           oshmpi_eager_pending; /* slots that may have a live request */
+
+void oshmpi_eager_init(void)
+{
+    long threshold = oshmpi_getenv_long("OSHMPI_EAGER_THRESHOLD", 4096);
+    long pool_size = oshmpi_getenv_long("OSHMPI_EAGER_POOL_SIZE", 262144);
+
+    oshmpi_eager_threshold = 0;
+    oshmpi_eager_nslots    = 0;
+    oshmpi_eager_head      = 0;
+    oshmpi_eager_pending   = 0;
+
+    if (threshold<=0 || pool_size<threshold) {
+        return;
+    }
+
+    oshmpi_eager_nslots = (int)(pool_size/threshold);
+    MPI_Alloc_mem((MPI_Aint)oshmpi_eager_nslots*threshold, MPI_INFO_NULL, &oshmpi_eager_pool);
+    oshmpi_eager_reqs = malloc(oshmpi_eager_nslots*sizeof(MPI_Request)); assert(oshmpi_eager_reqs!=NULL);
+    for (int i=0; i<oshmpi_eager_nslots; i++)
+        oshmpi_eager_reqs[i] = MPI_REQUEST_NULL;
+
+    oshmpi_eager_threshold = (size_t)threshold;
+}
+
+void oshmpi_eager_finalize(void)
+{
+    if (oshmpi_eager_nslots>0) {
+        MPI_Waitall(oshmpi_eager_nslots, oshmpi_eager_reqs, MPI_STATUSES_IGNORE);
+        free(oshmpi_eager_reqs);
+        MPI_Free_mem(oshmpi_eager_pool);
+    }
+    oshmpi_eager_threshold = 0;
+    oshmpi_eager_nslots    = 0;
+}
+
+void oshmpi_eager_reap(void)
+{
+    /* Every request is complete at this point, so this only frees them. */
+    if (oshmpi_eager_pending>0) {
+        MPI_Waitall(oshmpi_eager_nslots, oshmpi_eager_reqs, MPI_STATUSES_IGNORE);
+        oshmpi_eager_pending = 0;
+    }
+}
+
+void oshmpi_put_eager(void *target, const void *source, size_t len, int pe)
+{
+    enum shmem_window_id_e win_id;
+    shmem_offset_t win_offset;
+
+    if ( unlikely(oshmpi_cma_offset(target, pe, &win_offset)) && 0==oshmpi_cma_put(win_offset, source, len, pe) ) {
+        return;
+    }
+
+    if (oshmpi_window_offset(target, pe, &win_id, &win_offset)) {
+        oshmpi_abort(pe, "oshmpi_window_offset failed to find put target");
+    }
+
+    MPI_Win win = oshmpi_win(win_id);
+
+    int slot = oshmpi_eager_head;
+    oshmpi_eager_head = (slot+1<oshmpi_eager_nslots) ? slot+1 : 0;
+
+    /* recycle: this is the only place a put waits for local completion */
+    if (oshmpi_eager_reqs[slot]!=MPI_REQUEST_NULL) {
+        MPI_Wait(&oshmpi_eager_reqs[slot], MPI_STATUS_IGNORE);
+    } else if (oshmpi_eager_pending<oshmpi_eager_nslots) {
+        oshmpi_eager_pending++;
+    }
+
+    char * buf = oshmpi_eager_pool + (size_t)slot*oshmpi_eager_threshold;
+    memcpy(buf, source, len);
+
+    if (oshmpi_win_atomic_rma(win_id)) {
+        MPI_Raccumulate(buf, (int)len, MPI_BYTE,                   /* origin */
+                        pe, (MPI_Aint)win_offset, (int)len, MPI_BYTE, /* target */
+                        MPI_REPLACE,                                /* atomic, ordered Put */
+                        win, &oshmpi_eager_reqs[slot]);
+    } else {
+        MPI_Rput(buf, (int)len, MPI_BYTE,                   /* origin */
+                 pe, (MPI_Aint)win_offset, (int)len, MPI_BYTE, /* target */
+                 win, &oshmpi_eager_reqs[slot]);
+    }
+    return;
+}
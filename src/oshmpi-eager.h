@@ -0,0 +1,29 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#ifndef OSHMPI_EAGER_H
+#define OSHMPI_EAGER_H
+
+#include "shmem-internals.h"
+
+/* Eager protocol for small puts that go through MPI.
+ *
+ * A put of at most OSHMPI_EAGER_THRESHOLD bytes is copied into a slot of a
+ * bounce buffer pool of OSHMPI_EAGER_POOL_SIZE bytes (from MPI_Alloc_mem, so
+ * it can be registered once) and issued from there with MPI_Rput, so the
+ * put returns without waiting for local completion.  Slots are used in
+ * ring order and the request of a slot is only waited on when the ring
+ * comes back to it, or when quiet/fence/barrier complete everything anyway.
+ * OSHMPI_EAGER_THRESHOLD=0 disables the protocol. */
+
+extern size_t oshmpi_eager_threshold;
+
+void oshmpi_eager_init(void);
+void oshmpi_eager_finalize(void);
+
+/* put of len bytes, len<=oshmpi_eager_threshold */
+void oshmpi_put_eager(void *target, const void *source, size_t len, int pe);
+
+/* Called after every pending operation has completed remotely. */
+void oshmpi_eager_reap(void);
+
+#endif /* OSHMPI_EAGER_H */
@@ -9,34 +9,32 @@
 #define LOCK_DISP 3
 #define TAIL 	  0
 
-MPI_Win oshmpi_lock_win = MPI_WIN_NULL;
+/* in bytes, since the window of the symmetric heap has disp_unit 1 */
+#define DISP(i)   (oshmpi_lock_disp + (MPI_Aint)(i) * (MPI_Aint)sizeof (int))
+#define LOCK_WIN  shmem_sheap_win
+
+MPI_Aint oshmpi_lock_disp = 0;
 int * oshmpi_lock_base = NULL;
 
-void oshmpi_allock(MPI_Comm comm)
+void oshmpi_allock(void)
 {
-  MPI_Info lock_info=MPI_INFO_NULL;
-  MPI_Info_create(&lock_info);
-
-  /* We define the sheap size to be symmetric and assume it for the global static data. */
-  MPI_Info_set(lock_info, "same_size", "true");
+  /* Every PE allocates this at the same point, so it has the same offset everywhere. */
+  oshmpi_lock_base = shmalloc (4 * sizeof (int));
+  assert (oshmpi_lock_base != NULL);
+  oshmpi_lock_disp = (MPI_Aint) ((intptr_t) oshmpi_lock_base - (intptr_t) shmem_sheap_base_ptr);
 
-  MPI_Win_allocate (4 * sizeof (int), sizeof (int), lock_info,
-		    comm, &oshmpi_lock_base, &oshmpi_lock_win);
   oshmpi_lock_base[NEXT_DISP] = -1;
   oshmpi_lock_base[PREV_DISP] = -1;
   oshmpi_lock_base[TAIL_DISP] = -1;
   oshmpi_lock_base[LOCK_DISP] = -1;
-  MPI_Win_lock_all (TAIL, oshmpi_lock_win);
-
-  MPI_Info_free(&lock_info);
 
   return;
 }
 
 void oshmpi_deallock(void)
 {
-  MPI_Win_unlock_all (oshmpi_lock_win);
-  MPI_Win_free (&oshmpi_lock_win);
+  shfree (oshmpi_lock_base);
+  oshmpi_lock_base = NULL;
   return;
 }
 
@@ -46,21 +44,31 @@ void oshmpi_lock(long * lockp)
   oshmpi_lock_t *lock = (oshmpi_lock_t *) lockp;
   /* Replace myself with the last tail */
   MPI_Fetch_and_op (&shmem_world_rank, &(lock->prev), MPI_INT, TAIL,
-		    TAIL_DISP, MPI_REPLACE, oshmpi_lock_win);
-  MPI_Win_flush (TAIL, oshmpi_lock_win);
+		    DISP (TAIL_DISP), MPI_REPLACE, LOCK_WIN);
+  MPI_Win_flush (TAIL, LOCK_WIN);
 
   /* Previous proc holding lock will eventually notify */
   if (lock->prev != -1)
     {
       /* Send my shmem_world_rank to previous proc's next */
-      MPI_Accumulate (&shmem_world_rank, 1, MPI_INT, lock->prev, NEXT_DISP,
-		      1, MPI_INT, MPI_REPLACE, oshmpi_lock_win);
-      MPI_Win_flush (lock->prev, oshmpi_lock_win);
+      MPI_Accumulate (&shmem_world_rank, 1, MPI_INT, lock->prev, DISP (NEXT_DISP),
+		      1, MPI_INT, MPI_REPLACE, LOCK_WIN);
+      MPI_Win_flush (lock->prev, LOCK_WIN);
+      if (oshmpi_etext_pending ())
+	{
+	  /* the previous holder may be creating the etext window */
+	  int flag = 0;
+	  while (!flag)
+	    {
+	      MPI_Iprobe (lock->prev, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, &status);
+	      oshmpi_etext_poll ();
+	    }
+	}
       MPI_Probe (lock->prev, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
     }
   /* Hold lock */
   oshmpi_lock_base[LOCK_DISP] = 1;
-  MPI_Win_sync (oshmpi_lock_win);
+  MPI_Win_sync (LOCK_WIN);
 
   return;
 }
@@ -70,8 +78,8 @@ void oshmpi_unlock(long * lockp)
   oshmpi_lock_t *lock = (oshmpi_lock_t *) lockp;
   /* Determine my next process */
   MPI_Fetch_and_op (NULL, &(lock->next), MPI_INT, shmem_world_rank,
-		    NEXT_DISP, MPI_NO_OP, oshmpi_lock_win);
-  MPI_Win_flush (shmem_world_rank, oshmpi_lock_win);
+		    DISP (NEXT_DISP), MPI_NO_OP, LOCK_WIN);
+  MPI_Win_flush (shmem_world_rank, LOCK_WIN);
 
   if (lock->next != -1)
     {
@@ -79,7 +87,7 @@ void oshmpi_unlock(long * lockp)
     }
   /* Release lock */
   oshmpi_lock_base[LOCK_DISP] = -1;
-  MPI_Win_sync (oshmpi_lock_win);
+  MPI_Win_sync (LOCK_WIN);
 
   return;
 }
@@ -91,25 +99,25 @@ int oshmpi_trylock(long * lockp)
   lock->prev = -1;
   /* Get the last tail, if -1 replace with me */
   MPI_Compare_and_swap (&shmem_world_rank, &nil, &(lock->prev), MPI_INT,
-			TAIL, TAIL_DISP, oshmpi_lock_win);
-  MPI_Win_flush (TAIL, oshmpi_lock_win);
+			TAIL, DISP (TAIL_DISP), LOCK_WIN);
+  MPI_Win_flush (TAIL, LOCK_WIN);
   /* Find if the last proc is holding lock */
   if (lock->prev != -1)
     {
       MPI_Fetch_and_op (NULL, &is_locked, MPI_INT, lock->prev,
-			LOCK_DISP, MPI_NO_OP, oshmpi_lock_win);
-      MPI_Win_flush (lock->prev, oshmpi_lock_win);
+			DISP (LOCK_DISP), MPI_NO_OP, LOCK_WIN);
+      MPI_Win_flush (lock->prev, LOCK_WIN);
 
       if (is_locked)
 	return 0;
     }
   /* Add myself in tail */
   MPI_Fetch_and_op (&shmem_world_rank, &(lock->prev), MPI_INT, TAIL,
-		    TAIL_DISP, MPI_REPLACE, oshmpi_lock_win);
-  MPI_Win_flush (TAIL, oshmpi_lock_win);
+		    DISP (TAIL_DISP), MPI_REPLACE, LOCK_WIN);
+  MPI_Win_flush (TAIL, LOCK_WIN);
   /* Hold lock */
   oshmpi_lock_base[LOCK_DISP] = 1;
-  MPI_Win_sync (oshmpi_lock_win);
+  MPI_Win_sync (LOCK_WIN);
 
   return 1;
 }
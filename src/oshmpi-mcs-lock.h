@@ -5,8 +5,10 @@
 
 #include "shmem-internals.h"
 
-/* MPI Lock */
-extern MPI_Win oshmpi_lock_win;
+/* MPI Lock
+ * The queue words are allocated from the symmetric heap at initialization
+ * and accessed through its window, rather than a window of their own. */
+extern MPI_Aint oshmpi_lock_disp;
 extern int * oshmpi_lock_base;
 
 typedef struct oshmpi_lock_s
@@ -15,7 +17,7 @@ typedef struct oshmpi_lock_s
   int next;
 } oshmpi_lock_t;
 
-void oshmpi_allock(MPI_Comm comm);
+void oshmpi_allock(void);
 void oshmpi_deallock(void);
 void oshmpi_lock(long * lockp);
 void oshmpi_unlock(long * lockp);
@@ -0,0 +1,176 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#include "oshmpi-sheap-cache.h"
+
+size_t oshmpi_sheap_cache_max;
+int    oshmpi_sheap_cache_max_class = -1;
+int    oshmpi_sheap_cache_depth;
+__thread oshmpi_sheap_magazine_t oshmpi_sheap_magazine;
+
+volatile int oshmpi_sheap_lock_word;
+
+static int oshmpi_sheap_stats_enabled;
+
+void oshmpi_sheap_cache_init(void)
+{
+    const long max_class_size = 1L<<(OSHMPI_SHEAP_CACHE_MIN_SHIFT+OSHMPI_SHEAP_CACHE_CLASSES-1);
+
+    long max   = oshmpi_getenv_long("OSHMPI_SHEAP_CACHE_MAX", 65536);
+    long depth = oshmpi_getenv_long("OSHMPI_SHEAP_CACHE_DEPTH", 16);
+
+    if (max>max_class_size) {
+        oshmpi_warn("OSHMPI_SHEAP_CACHE_MAX is too large - using the largest size class");
+        max = max_class_size;
+    }
+    if (depth>OSHMPI_SHEAP_CACHE_DEPTH_MAX) depth = OSHMPI_SHEAP_CACHE_DEPTH_MAX;
+    if (max<=0 || depth<=0) {
+        max   = 0;
+        depth = 0;
+    }
+
+    oshmpi_sheap_cache_max       = (size_t)max;
+    oshmpi_sheap_cache_depth     = (int)depth;
+    oshmpi_sheap_cache_max_class = (max>0) ? oshmpi_sheap_cache_class((size_t)max) : -1;
+
+    oshmpi_sheap_stats_enabled = (int)oshmpi_getenv_long("OSHMPI_HEAP_STATS", 0);
+
+#if SHMEM_DEBUG>0
+    if (shmem_world_rank==0) {
+        printf("OSHMPI symmetric heap cache: up to %ld bytes, %ld blocks per class\n", max, depth);
+    }
+#endif
+}
+
+void oshmpi_sheap_cache_drain(int c)
+{
+    oshmpi_sheap_magazine_t * m = &oshmpi_sheap_magazine;
+    int half = (m->count[c]+1)/2;
+
+    oshmpi_sheap_lock();
+    for (int i=0; i<half; i++) {
+        oshmpi_sheap_count_free(mspace_usable_size(m->slots[c][i]));
+        mspace_free(shmem_heap_mspace, m->slots[c][i]);
+    }
+    oshmpi_sheap_unlock();
+
+    m->count[c] -= half;
+    memmove(&m->slots[c][0], &m->slots[c][half], m->count[c]*sizeof(void*));
+}
+
+/* with the lock held; returns the number of blocks given back */
+int oshmpi_sheap_cache_flush(void)
+{
+    oshmpi_sheap_magazine_t * m = &oshmpi_sheap_magazine;
+    int n = 0;
+    for (int c=0; c<=oshmpi_sheap_cache_max_class; c++) {
+        for (int i=0; i<m->count[c]; i++) {
+            oshmpi_sheap_count_free(mspace_usable_size(m->slots[c][i]));
+            mspace_free(shmem_heap_mspace, m->slots[c][i]);
+        }
+        n += m->count[c];
+        m->count[c] = 0;
+    }
+    return n;
+}
+
+void * oshmpi_sheap_cache_miss(size_t alignment, size_t size)
+{
+    void * ptr;
+
+    oshmpi_sheap_lock();
+    if ( unlikely(size>=oshmpi_sheap_large_threshold) ) {
+        /* zone regions are at least page-aligned */
+        ptr = (alignment<=(size_t)oshmpi_sheap_page_size) ? oshmpi_sheap_zone_alloc(size) : NULL;
+        if (ptr!=NULL) {
+            oshmpi_sheap_count_alloc(oshmpi_sheap_zone_usable_size(ptr));
+            oshmpi_sheap_unlock();
+            return ptr;
+        }
+    }
+    ptr = (alignment>0) ? mspace_memalign(shmem_heap_mspace, alignment, size)
+                        : mspace_malloc(shmem_heap_mspace, size);
+    if ( unlikely(ptr==NULL) && size>0 && oshmpi_sheap_cache_flush()>0 ) {
+        ptr = (alignment>0) ? mspace_memalign(shmem_heap_mspace, alignment, size)
+                            : mspace_malloc(shmem_heap_mspace, size);
+    }
+    if ( likely(ptr!=NULL) ) {
+        oshmpi_sheap_count_alloc(mspace_usable_size(ptr));
+    } else if (size>0) {
+        /* counts for itself */
+        ptr = oshmpi_sheap_segment_alloc(alignment, size);
+    }
+    oshmpi_sheap_unlock();
+
+    return ptr;
+}
+
+/* mspace_inspect_all callback, which sees every chunk */
+static void oshmpi_sheap_count_free_chunk(void * start, void * end, size_t used_bytes, void * arg)
+{
+    oshmpi_sheap_stats_t * stats = arg;
+    size_t size = (size_t)((char*)end - (char*)start);
+    if (used_bytes==0) {
+        stats->free += size;
+        if (size>stats->largest_free) stats->largest_free = size;
+    }
+}
+
+void oshmpi_sheap_stats(oshmpi_sheap_stats_t * stats)
+{
+    oshmpi_sheap_magazine_t * m = &oshmpi_sheap_magazine;
+
+    oshmpi_sheap_lock();
+
+    /* mspace_mallinfo would do, but struct mallinfo is not declared with
+     * ONLY_MSPACES, and this also finds the largest free block. */
+    stats->size         = (size_t)shmem_sheap_size;
+    stats->free         = 0;
+    stats->largest_free = 0;
+    stats->segments     = 0;
+    mspace_inspect_all(shmem_heap_mspace, oshmpi_sheap_count_free_chunk, stats);
+    oshmpi_sheap_zone_stats(&stats->free, &stats->largest_free);
+    for (int i=0; i<oshmpi_num_segments; i++) {
+        if (oshmpi_segments[i].flags & OSHMPI_SEGMENT_SPACE) continue;
+        stats->size += oshmpi_segments[i].size;
+        stats->segments++;
+        mspace_inspect_all(oshmpi_segments[i].msp, oshmpi_sheap_count_free_chunk, stats);
+    }
+    stats->in_use     = oshmpi_sheap_in_use;
+    stats->high_water = oshmpi_sheap_high_water;
+
+    stats->cached = 0;
+    for (int c=0; c<=oshmpi_sheap_cache_max_class; c++)
+        for (int i=0; i<m->count[c]; i++)
+            stats->cached += mspace_usable_size(m->slots[c][i]);
+
+    oshmpi_sheap_unlock();
+}
+
+void oshmpi_sheap_stats_report(void)
+{
+    if (!oshmpi_sheap_stats_enabled) return;
+
+    oshmpi_sheap_stats_t s;
+    oshmpi_sheap_stats(&s);
+
+    /* size, in use, high water, free, largest free, fragmentation */
+    double in[6] = { (double)s.size, (double)s.in_use, (double)s.high_water,
+                     (double)s.free, (double)s.largest_free,
+                     (s.free>0) ? 1.0 - (double)s.largest_free/s.free : 0.0 };
+    double min[6], max[6], sum[6];
+    MPI_Reduce(in, min, 6, MPI_DOUBLE, MPI_MIN, 0, SHMEM_COMM_WORLD);
+    MPI_Reduce(in, max, 6, MPI_DOUBLE, MPI_MAX, 0, SHMEM_COMM_WORLD);
+    MPI_Reduce(in, sum, 6, MPI_DOUBLE, MPI_SUM, 0, SHMEM_COMM_WORLD);
+    if (shmem_world_rank==0) {
+        static const char * names[6] = { "size", "in use", "high water", "free", "largest free", "fragmentation" };
+        printf("OSHMPI symmetric heap (bytes)   min           avg           max\n");
+        for (int i=0; i<6; i++) {
+            if (i<5) {
+                printf("  %-14s %13.0f %13.0f %13.0f\n", names[i], min[i], sum[i]/shmem_world_size, max[i]);
+            } else {
+                printf("  %-14s %13.3f %13.3f %13.3f\n", names[i], min[i], sum[i]/shmem_world_size, max[i]);
+            }
+        }
+        fflush(stdout);
+    }
+}
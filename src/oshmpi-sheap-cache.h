@@ -0,0 +1,118 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#ifndef OSHMPI_SHEAP_CACHE_H
+#define OSHMPI_SHEAP_CACHE_H
+
+#include "shmem-internals.h"
+#include "oshmpi-sheap.h"
+
+/* Size-class cache in front of the symmetric heap allocator.
+ *
+ * shmalloc requests of at most OSHMPI_SHEAP_CACHE_MAX bytes (default 64K,
+ * 0 disables the cache) are rounded up to a power of two, and shfree keeps
+ * freed blocks in a per-thread magazine of OSHMPI_SHEAP_CACHE_DEPTH blocks
+ * per size class (default 16) rather than returning them to dlmalloc, so
+ * the allocate/free of a same-sized buffer is a pop and a push with no lock.
+ *
+ * The cache does not break symmetry: the magazines are LIFO and a full one
+ * returns its oldest half to dlmalloc, so a PE's heap only depends on the
+ * sequence of calls each thread makes, which symmetric allocation requires
+ * to be the same on every PE.  dlmalloc itself is behind a spinlock. */
+
+#define OSHMPI_SHEAP_CACHE_MIN_SHIFT 4  /* 16 bytes */
+#define OSHMPI_SHEAP_CACHE_CLASSES   16 /* up to 512K */
+#define OSHMPI_SHEAP_CACHE_DEPTH_MAX 64
+
+typedef struct oshmpi_sheap_magazine_s
+{
+    int    count[OSHMPI_SHEAP_CACHE_CLASSES];
+    void * slots[OSHMPI_SHEAP_CACHE_CLASSES][OSHMPI_SHEAP_CACHE_DEPTH_MAX];
+} oshmpi_sheap_magazine_t;
+
+extern size_t oshmpi_sheap_cache_max;       /* 0 if the cache is disabled */
+extern int    oshmpi_sheap_cache_max_class;
+extern int    oshmpi_sheap_cache_depth;
+extern __thread oshmpi_sheap_magazine_t oshmpi_sheap_magazine;
+
+extern volatile int oshmpi_sheap_lock_word;
+
+void oshmpi_sheap_cache_init(void);
+
+static inline void oshmpi_sheap_lock(void)
+{
+    while (__sync_lock_test_and_set(&oshmpi_sheap_lock_word, 1)) {
+        while (oshmpi_sheap_lock_word)
+            OSHMPI_CPU_RELAX();
+    }
+}
+
+static inline void oshmpi_sheap_unlock(void)
+{
+    __sync_lock_release(&oshmpi_sheap_lock_word);
+}
+
+/* Allocation that the cache did not satisfy, with the lock taken inside.
+ * If the heap is full, the calling thread's magazines are emptied and the
+ * allocation retried before the heap grows or NULL is returned. */
+void * oshmpi_sheap_cache_miss(size_t alignment, size_t size);
+
+/* returns the oldest half of a full magazine to dlmalloc */
+void   oshmpi_sheap_cache_drain(int c);
+
+/* Returns all blocks in the calling thread's magazines to dlmalloc, with
+ * the lock held, and the number of blocks returned. */
+int    oshmpi_sheap_cache_flush(void);
+
+/* the smallest class that holds size bytes, for 0 < size <= oshmpi_sheap_cache_max */
+static inline int oshmpi_sheap_cache_class(size_t size)
+{
+    if (size <= (1UL<<OSHMPI_SHEAP_CACHE_MIN_SHIFT)) return 0;
+    return (int)(8*sizeof(unsigned long)) - __builtin_clzl((unsigned long)(size-1)) - OSHMPI_SHEAP_CACHE_MIN_SHIFT;
+}
+
+/* for 0 < size <= oshmpi_sheap_cache_max */
+static inline void * oshmpi_sheap_cache_malloc(size_t size)
+{
+    int c = oshmpi_sheap_cache_class(size);
+    oshmpi_sheap_magazine_t * m = &oshmpi_sheap_magazine;
+    if ( likely(m->count[c]>0) ) {
+        return m->slots[c][--m->count[c]];
+    }
+    return oshmpi_sheap_cache_miss(0, (size_t)1<<(c+OSHMPI_SHEAP_CACHE_MIN_SHIFT));
+}
+
+/* Keeps a block of the initial heap with usable_size bytes, if it fits a
+ * class, and returns 1, or returns 0 and the caller frees it. */
+static inline int oshmpi_sheap_cache_free(void * ptr, size_t usable_size)
+{
+    if ( unlikely(usable_size < (1UL<<OSHMPI_SHEAP_CACHE_MIN_SHIFT)) ) return 0;
+    /* the largest class that fits in the block */
+    int c = (int)(8*sizeof(unsigned long)) - 1 - __builtin_clzl((unsigned long)usable_size) - OSHMPI_SHEAP_CACHE_MIN_SHIFT;
+    if (c > oshmpi_sheap_cache_max_class) return 0;
+
+    oshmpi_sheap_magazine_t * m = &oshmpi_sheap_magazine;
+    if ( unlikely(m->count[c]==oshmpi_sheap_cache_depth) ) {
+        oshmpi_sheap_cache_drain(c);
+    }
+    m->slots[c][m->count[c]++] = ptr;
+    return 1;
+}
+
+/* Usage of the symmetric heap and the segments added to it, not spaces.
+ * With OSHMPI_HEAP_STATS=1, PE 0 prints a summary across PEs at finalize. */
+typedef struct oshmpi_sheap_stats_s
+{
+    size_t size;
+    size_t in_use;       /* in allocated blocks, including cached ones */
+    size_t cached;       /* in the calling thread's magazines */
+    size_t free;
+    size_t largest_free;
+    size_t high_water;   /* of in_use */
+    int    segments;
+} oshmpi_sheap_stats_t;
+
+void oshmpi_sheap_stats(oshmpi_sheap_stats_t * stats);
+/* Collective */
+void oshmpi_sheap_stats_report(void);
+
+#endif /* OSHMPI_SHEAP_CACHE_H */
@@ -0,0 +1,727 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#define _GNU_SOURCE /* memfd_create, MAP_HUGETLB */
+
+#include "oshmpi-sheap.h"
+
+#if defined(HAVE_LINUX)
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+int  oshmpi_sheap_pages;
+long oshmpi_sheap_page_size;
+
+static void *  oshmpi_sheap_map_base;  /* NULL if MPI allocated the heap */
+static size_t  oshmpi_sheap_map_size;
+static void ** oshmpi_sheap_peer_maps; /* our mappings of other PEs' segments */
+static int     oshmpi_sheap_npeers;
+static int     oshmpi_sheap_shared;    /* the segments are memfds */
+
+size_t oshmpi_sheap_release_threshold = SIZE_MAX;
+
+static const char * oshmpi_sheap_pages_names[] = { "default", "transparent huge", "hugetlb" };
+
+#if defined(HAVE_LINUX)
+
+/* Returns the number in a sysfs file, or the value of a line of
+ * /proc/meminfo in bytes, or 0. */
+static long oshmpi_sheap_read_long(const char * path, const char * key)
+{
+    FILE * f = fopen(path, "r");
+    long value = 0;
+    if (f==NULL) return 0;
+    if (key==NULL) {
+        if (fscanf(f, "%ld", &value)!=1) value = 0;
+    } else {
+        char line[256];
+        size_t keylen = strlen(key);
+        while (fgets(line, sizeof(line), f)!=NULL) {
+            if (0==strncmp(line, key, keylen)) {
+                value = 1024*atol(line+keylen); /* in kB */
+                break;
+            }
+        }
+    }
+    fclose(f);
+    return value;
+}
+
+static long oshmpi_sheap_huge_size(int pages)
+{
+    long size = 0;
+    if (pages==OSHMPI_SHEAP_PAGES_DEFAULT)
+        return sysconf(_SC_PAGESIZE);
+    if (pages==OSHMPI_SHEAP_PAGES_HUGETLB)
+        size = oshmpi_sheap_read_long("/proc/meminfo", "Hugepagesize:");
+    else if (pages==OSHMPI_SHEAP_PAGES_THP)
+        size = oshmpi_sheap_read_long("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", NULL);
+    return (size>0) ? size : 2*1024*1024;
+}
+
+/* Maps size bytes with the requested pages, or the next best thing.
+ * Returns the kind of pages obtained, or -1 on failure.  *fd is -1 unless shared. */
+static int oshmpi_sheap_map(size_t size, int pages, int shared, int noreserve, void ** base, int * fd)
+{
+    void * p = MAP_FAILED;
+    /* hugetlb pages must be reserved, or touching one may SIGBUS */
+    int nr = noreserve ? MAP_NORESERVE : 0;
+    *fd = -1;
+
+    if (shared) {
+#if !defined(HAVE_MEMFD_CREATE)
+        return -1;
+#else
+#if defined(MFD_HUGETLB)
+        if (pages==OSHMPI_SHEAP_PAGES_HUGETLB) {
+            *fd = memfd_create("oshmpi-sheap", MFD_CLOEXEC | MFD_HUGETLB);
+            /* mmap of hugetlbfs reserves the pages, so it fails here if the pool is short */
+            if (*fd>=0 && 0==ftruncate(*fd, size))
+                p = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, *fd, 0);
+            if (p==MAP_FAILED && *fd>=0) {
+                close(*fd);
+                *fd = -1;
+            }
+        }
+#endif
+        if (p==MAP_FAILED) {
+            if (pages==OSHMPI_SHEAP_PAGES_HUGETLB) pages = OSHMPI_SHEAP_PAGES_THP;
+            *fd = memfd_create("oshmpi-sheap", MFD_CLOEXEC);
+            if (*fd<0) return -1;
+            if (0==ftruncate(*fd, size))
+                p = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED|nr, *fd, 0);
+            if (p==MAP_FAILED) {
+                close(*fd);
+                *fd = -1;
+                return -1;
+            }
+        }
+#endif /* HAVE_MEMFD_CREATE */
+    } else {
+#if defined(MAP_HUGETLB)
+        if (pages==OSHMPI_SHEAP_PAGES_HUGETLB)
+            p = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+#endif
+        if (p==MAP_FAILED) {
+            if (pages==OSHMPI_SHEAP_PAGES_HUGETLB) pages = OSHMPI_SHEAP_PAGES_THP;
+            p = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|nr, -1, 0);
+            if (p==MAP_FAILED) return -1;
+        }
+    }
+
+#if defined(MADV_HUGEPAGE)
+    /* For memfd this needs shmem_enabled=advise (or always) in sysfs. */
+    if (pages==OSHMPI_SHEAP_PAGES_THP)
+        madvise(p, size, MADV_HUGEPAGE);
+#endif
+
+    *base = p;
+    return pages;
+}
+
+#endif /* HAVE_LINUX */
+
+int oshmpi_sheap_create(MPI_Aint size, MPI_Info info, int is_smp,
+                        void ** base, MPI_Win * win, void *** smp_ptrs)
+{
+    oshmpi_sheap_pages     = OSHMPI_SHEAP_PAGES_DEFAULT;
+    oshmpi_sheap_page_size = sysconf(_SC_PAGESIZE);
+    oshmpi_sheap_map_base  = NULL;
+    oshmpi_sheap_release_threshold = SIZE_MAX;
+
+    int noreserve = (int)oshmpi_getenv_long("OSHMPI_SHEAP_NORESERVE", 0);
+
+    char * env_char = getenv("OSHMPI_SHEAP_HUGEPAGES");
+    int pages = OSHMPI_SHEAP_PAGES_DEFAULT;
+    if (env_char!=NULL) {
+        if (0==strcmp(env_char, "thp")) {
+            pages = OSHMPI_SHEAP_PAGES_THP;
+        } else if (0==strcmp(env_char, "hugetlb")) {
+            pages = OSHMPI_SHEAP_PAGES_HUGETLB;
+        } else if (0!=strcmp(env_char, "none")) {
+            oshmpi_warn("OSHMPI_SHEAP_HUGEPAGES is not one of none, thp or hugetlb - using none");
+        }
+    }
+    if (pages==OSHMPI_SHEAP_PAGES_DEFAULT && !noreserve) {
+        return 0;
+    }
+
+#if defined(HAVE_LINUX)
+    /* round up to whole pages of the larger kind */
+    long   huge = oshmpi_sheap_huge_size(pages);
+    size_t map_size = ((size_t)size + huge - 1) / huge * huge;
+    void * p  = NULL;
+    int    fd = -1;
+
+    int obtained = oshmpi_sheap_map(map_size, pages, is_smp, noreserve, &p, &fd);
+
+    /* everyone falls back if anyone failed */
+    int ok = (obtained>=0);
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, SHMEM_COMM_WORLD);
+    if (!ok) {
+        if (obtained>=0) munmap(p, map_size);
+        if (fd>=0) close(fd);
+        oshmpi_warn("mapping the symmetric heap failed - using MPI");
+        return 0;
+    }
+
+    if (is_smp) {
+        struct { int pid; int fd; } me = { (int)getpid(), fd }, * all;
+        all = malloc(shmem_world_size*sizeof(*all)); assert(all!=NULL);
+        MPI_Allgather(&me, 2, MPI_INT, all, 2, MPI_INT, SHMEM_COMM_WORLD);
+
+        void ** ptrs = malloc(shmem_world_size*sizeof(void*)); assert(ptrs!=NULL);
+        oshmpi_sheap_peer_maps = malloc(shmem_world_size*sizeof(void*)); assert(oshmpi_sheap_peer_maps!=NULL);
+        oshmpi_sheap_npeers = shmem_world_size;
+        int mapped = 1;
+        for (int i=0; i<shmem_world_size; i++) {
+            oshmpi_sheap_peer_maps[i] = NULL;
+            if (i==shmem_world_rank) {
+                ptrs[i] = p;
+                continue;
+            }
+            /* Another user's /proc/<pid>/fd, or a hardened /proc, makes this
+             * fail, and then the node uses MPI shared memory instead. */
+            char path[64];
+            snprintf(path, sizeof(path), "/proc/%d/fd/%d", all[i].pid, all[i].fd);
+            int pfd = mapped ? open(path, O_RDWR) : -1;
+            void * q = (pfd<0) ? MAP_FAILED : mmap(NULL, map_size, PROT_READ|PROT_WRITE, MAP_SHARED, pfd, 0);
+            if (pfd>=0) close(pfd);
+            if (q==MAP_FAILED) {
+                mapped = 0;
+                continue;
+            }
+            ptrs[i] = oshmpi_sheap_peer_maps[i] = q;
+        }
+        free(all);
+
+        /* This also keeps our descriptor open until everyone has mapped it. */
+        MPI_Allreduce(MPI_IN_PLACE, &mapped, 1, MPI_INT, MPI_MIN, SHMEM_COMM_WORLD);
+        close(fd);
+        if (!mapped) {
+            for (int i=0; i<shmem_world_size; i++) {
+                if (oshmpi_sheap_peer_maps[i]!=NULL)
+                    munmap(oshmpi_sheap_peer_maps[i], map_size);
+            }
+            free(oshmpi_sheap_peer_maps);
+            oshmpi_sheap_peer_maps = NULL;
+            oshmpi_sheap_npeers    = 0;
+            free(ptrs);
+            munmap(p, map_size);
+            oshmpi_warn("mapping the symmetric heap of another PE failed - using MPI");
+            return 0;
+        }
+        *smp_ptrs = ptrs;
+    }
+
+    oshmpi_sheap_pages     = obtained;
+    oshmpi_sheap_page_size = oshmpi_sheap_huge_size(obtained);
+    oshmpi_sheap_map_base  = p;
+    oshmpi_sheap_map_size  = map_size;
+    oshmpi_sheap_shared    = is_smp;
+    /* Pages given back under a window that MPI may have registered with the
+     * network would leave the registration pointing at frames that are no
+     * longer ours, so this is only done when the window is shared memory. */
+    if (noreserve && is_smp) {
+        long threshold = oshmpi_getenv_long("OSHMPI_SHEAP_RELEASE_THRESHOLD", 1000000);
+        if (threshold>0) oshmpi_sheap_release_threshold = (size_t)threshold;
+    }
+
+    MPI_Win_create(p, size, 1 /* disp_unit */, info, SHMEM_COMM_WORLD, win);
+    *base = p;
+
+    if (shmem_world_rank==0) {
+        printf("OSHMPI symmetric heap uses %s pages of %ld bytes%s\n",
+               oshmpi_sheap_pages_names[oshmpi_sheap_pages], oshmpi_sheap_page_size,
+               noreserve ? ", committed on demand" : "");
+    }
+    return 1;
+#else
+    (void)size; (void)info; (void)is_smp; (void)base; (void)win; (void)smp_ptrs;
+    oshmpi_warn("OSHMPI_SHEAP_HUGEPAGES is only supported on Linux");
+    return 0;
+#endif
+}
+
+void oshmpi_sheap_destroy(void)
+{
+#if defined(HAVE_LINUX)
+    if (oshmpi_sheap_map_base==NULL) return;
+    for (int i=0; i<oshmpi_sheap_npeers; i++) {
+        if (oshmpi_sheap_peer_maps[i]!=NULL)
+            munmap(oshmpi_sheap_peer_maps[i], oshmpi_sheap_map_size);
+    }
+    free(oshmpi_sheap_peer_maps);
+    oshmpi_sheap_peer_maps = NULL;
+    oshmpi_sheap_npeers    = 0;
+    munmap(oshmpi_sheap_map_base, oshmpi_sheap_map_size);
+    oshmpi_sheap_map_base  = NULL;
+#endif
+}
+
+void oshmpi_sheap_release(void * ptr, size_t size)
+{
+#if defined(HAVE_LINUX)
+    /* Only whole pages of the payload, so the chunk header stays.  The block
+     * is not free yet, and the bookkeeping that mspace_free writes into it
+     * afterwards just faults those pages back in. */
+    uintptr_t page  = (uintptr_t)oshmpi_sheap_page_size;
+    uintptr_t start = ((uintptr_t)ptr + page - 1) & ~(page-1);
+    uintptr_t stop  = ((uintptr_t)ptr + size) & ~(page-1);
+    if (stop<=start) return;
+
+#if defined(MADV_REMOVE)
+    /* MADV_DONTNEED would only drop our mapping of a shared page */
+    madvise((void*)start, stop-start, oshmpi_sheap_shared ? MADV_REMOVE : MADV_DONTNEED);
+#else
+    if (!oshmpi_sheap_shared)
+        madvise((void*)start, stop-start, MADV_DONTNEED);
+#endif
+#else
+    (void)ptr; (void)size;
+#endif
+}
+
+/*****************************************************************/
+
+int oshmpi_sheap_growable;
+
+size_t oshmpi_sheap_in_use;
+size_t oshmpi_sheap_high_water;
+
+static size_t oshmpi_sheap_segment_size;
+/* segment indices sorted by base address, for oshmpi_segment_find */
+static int    oshmpi_segment_order[OSHMPI_MAX_SEGMENTS];
+
+void oshmpi_sheap_segments_init(void)
+{
+    oshmpi_num_segments       = 0;
+    oshmpi_sheap_growable     = (int)oshmpi_getenv_long("OSHMPI_SHEAP_GROWABLE", 0);
+    long size                 = oshmpi_getenv_long("OSHMPI_SHEAP_SEGMENT_SIZE", shmem_sheap_size);
+    oshmpi_sheap_segment_size = (size>0) ? (size_t)size : (size_t)shmem_sheap_size;
+}
+
+void oshmpi_sheap_segments_finalize(void)
+{
+    for (int i=0; i<oshmpi_num_segments; i++) {
+        MPI_Win_unlock_all(oshmpi_segments[i].win);
+        MPI_Win_free(&oshmpi_segments[i].win);
+        free(oshmpi_segments[i].smp_ptrs);
+    }
+    oshmpi_num_segments = 0;
+}
+
+int oshmpi_segment_find(const void *address, shmem_offset_t * offset)
+{
+    int lo = 0, hi = oshmpi_num_segments-1;
+    while (lo<=hi) {
+        int mid = (lo+hi)/2;
+        const oshmpi_segment_t * s = &oshmpi_segments[oshmpi_segment_order[mid]];
+        if ((const char*)address < s->base) {
+            hi = mid-1;
+        } else if ((const char*)address >= s->base + s->size) {
+            lo = mid+1;
+        } else {
+            *offset = (shmem_offset_t)((const char*)address - s->base);
+            return oshmpi_segment_order[mid];
+        }
+    }
+    return -1;
+}
+
+int oshmpi_sheap_segment_create(size_t size, MPI_Info hints, int flags)
+{
+    if (oshmpi_num_segments==OSHMPI_MAX_SEGMENTS) {
+        return -1;
+    }
+    if (oshmpi_etext_unsettled()) {
+        oshmpi_etext_barrier(0, 0, shmem_world_size);
+    }
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size = (size + page - 1) / page * page;
+
+    oshmpi_segment_t * s = &oshmpi_segments[oshmpi_num_segments];
+    void * base = NULL;
+    MPI_Info info;
+    if (hints!=MPI_INFO_NULL) {
+        MPI_Info_dup(hints, &info);
+    } else {
+        MPI_Info_create(&info);
+    }
+    MPI_Info_set(info, "same_size", "true");
+    s->smp_ptrs = NULL;
+    s->flags    = flags;
+#ifdef ENABLE_SMP_OPTIMIZATIONS
+    if (shmem_world_is_smp) {
+        MPI_Info_set(info, "alloc_shared_noncontig", "true");
+        MPI_Win_allocate_shared((MPI_Aint)size, 1 /* disp_unit */, info, SHMEM_COMM_WORLD, &base, &s->win);
+        s->smp_ptrs = malloc(shmem_world_size*sizeof(void*)); assert(s->smp_ptrs!=NULL);
+        for (int rank=0; rank<shmem_world_size; rank++) {
+            MPI_Aint rsize; /* unused */
+            int      disp;  /* unused */
+            MPI_Win_shared_query(s->win, rank, &rsize, &disp, &s->smp_ptrs[rank]);
+        }
+    } else
+#endif
+    {
+        MPI_Info_set(info, "alloc_shm", "true");
+        MPI_Win_allocate((MPI_Aint)size, 1 /* disp_unit */, info, SHMEM_COMM_WORLD, &base, &s->win);
+    }
+    MPI_Info_free(&info);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, s->win);
+
+#if defined(HAVE_LINUX) && defined(MADV_HUGEPAGE)
+    /* before dlmalloc touches it; the kernel may ignore it */
+    if (flags & OSHMPI_SEGMENT_HUGEPAGES) {
+        uintptr_t start = ((uintptr_t)base + page - 1) & ~(uintptr_t)(page - 1);
+        uintptr_t end   = ((uintptr_t)base + size) & ~(uintptr_t)(page - 1);
+        if (end>start) {
+            madvise((void*)start, end-start, MADV_HUGEPAGE);
+        }
+    }
+#endif
+
+    s->base = base;
+    s->size = size;
+    s->msp  = create_mspace_with_base(base, size, 0 /* locked */);
+    mspace_set_footprint_limit(s->msp, mspace_footprint(s->msp));
+
+    /* insert into the sorted order, which lookups may not see half-done
+     * because nothing else runs during a collective allocation */
+    int i = oshmpi_num_segments;
+    while (i>0 && oshmpi_segments[oshmpi_segment_order[i-1]].base > s->base) {
+        oshmpi_segment_order[i] = oshmpi_segment_order[i-1];
+        i--;
+    }
+    oshmpi_segment_order[i] = oshmpi_num_segments;
+
+    return oshmpi_num_segments++;
+}
+
+void oshmpi_sheap_segment_destroy(int i)
+{
+    oshmpi_segment_t * s = &oshmpi_segments[i];
+    if (oshmpi_etext_unsettled()) {
+        oshmpi_etext_barrier(0, 0, shmem_world_size);
+    }
+    MPI_Win_unlock_all(s->win);
+    MPI_Win_free(&s->win);
+    free(s->smp_ptrs);
+
+    /* close the gap, keeping the other segments in order */
+    for (int j=i+1; j<oshmpi_num_segments; j++)
+        oshmpi_segments[j-1] = oshmpi_segments[j];
+    int k = 0;
+    for (int j=0; j<oshmpi_num_segments; j++) {
+        if (oshmpi_segment_order[j]==i) continue;
+        oshmpi_segment_order[k++] = oshmpi_segment_order[j] - (oshmpi_segment_order[j]>i);
+    }
+    oshmpi_num_segments--;
+}
+
+/* Collective.  Returns the index of the new segment or -1. */
+static int oshmpi_sheap_grow(size_t need)
+{
+    if (!oshmpi_sheap_growable) {
+        return -1;
+    }
+
+    /* room for dlmalloc's bookkeeping and alignment padding */
+    size_t size = need + need/8 + 65536;
+    if (size<oshmpi_sheap_segment_size) size = oshmpi_sheap_segment_size;
+
+    int i = oshmpi_sheap_segment_create(size, MPI_INFO_NULL, 0);
+#if SHMEM_DEBUG>0
+    if (i>=0 && shmem_world_rank==0) {
+        printf("OSHMPI symmetric heap grew by %zu bytes (segment %d)\n", oshmpi_segments[i].size, i);
+    }
+#endif
+    return i;
+}
+
+void * oshmpi_sheap_segment_alloc(size_t alignment, size_t size)
+{
+    void * ptr = NULL;
+
+    /* the same order on every PE, so the result is symmetric */
+    for (int i=0; i<oshmpi_num_segments && ptr==NULL; i++) {
+        if (oshmpi_segments[i].flags & OSHMPI_SEGMENT_SPACE) continue;
+        ptr = (alignment>0) ? mspace_memalign(oshmpi_segments[i].msp, alignment, size)
+                            : mspace_malloc(oshmpi_segments[i].msp, size);
+    }
+
+    if (ptr==NULL) {
+        int i = oshmpi_sheap_grow(size + alignment);
+        if (i<0) return NULL;
+        ptr = (alignment>0) ? mspace_memalign(oshmpi_segments[i].msp, alignment, size)
+                            : mspace_malloc(oshmpi_segments[i].msp, size);
+    }
+    if (ptr!=NULL) {
+        oshmpi_sheap_count_alloc(mspace_usable_size(ptr));
+    }
+    return ptr;
+}
+
+void oshmpi_sheap_segment_free(void * ptr)
+{
+    shmem_offset_t offset;
+    int i = (ptr!=NULL) ? oshmpi_segment_find(ptr, &offset) : -1;
+    if (i>=0) {
+        if (!(oshmpi_segments[i].flags & OSHMPI_SEGMENT_SPACE)) {
+            oshmpi_sheap_count_free(mspace_usable_size(ptr));
+        }
+        mspace_free(oshmpi_segments[i].msp, ptr);
+    } else if (ptr!=NULL) {
+        oshmpi_abort(shmem_world_rank, "shfree: address is not in the symmetric heap");
+    }
+}
+
+void * oshmpi_sheap_segment_realloc(void * ptr, size_t size)
+{
+    /* in place if possible, wherever ptr lives */
+    shmem_offset_t offset;
+    int i = oshmpi_sheap_is_initial(ptr) ? -1 : oshmpi_segment_find(ptr, &offset);
+    mspace msp     = (i<0) ? shmem_heap_mspace : oshmpi_segments[i].msp;
+    int    counted = (i<0) || !(oshmpi_segments[i].flags & OSHMPI_SEGMENT_SPACE);
+    size_t old     = mspace_usable_size(ptr);
+
+    void * p = mspace_realloc(msp, ptr, size);
+    if (p!=NULL) {
+        if (counted) {
+            oshmpi_sheap_count_free(old);
+            oshmpi_sheap_count_alloc(mspace_usable_size(p));
+        }
+        return p;
+    }
+    if (!oshmpi_sheap_growable) return NULL;
+
+    p = oshmpi_sheap_segment_alloc(0, size);
+    if (p!=NULL) {
+        memcpy(p, ptr, (old<size) ? old : size);
+        if (counted) oshmpi_sheap_count_free(old);
+        mspace_free(msp, ptr);
+    }
+    return p;
+}
+
+/*****************************************************************/
+
+size_t oshmpi_sheap_large_threshold = SIZE_MAX;
+char * oshmpi_sheap_zone_base;
+size_t oshmpi_sheap_zone_size;
+
+/* Extents of the zone as offsets from its base, sorted by offset.  They live
+ * in private memory so that the zone itself is only touched by the
+ * application and free pages stay unbacked. */
+typedef struct { size_t off; size_t len; } oshmpi_extent_t;
+
+typedef struct {
+    oshmpi_extent_t * e;
+    int n, max;
+} oshmpi_extents_t;
+
+static oshmpi_extents_t oshmpi_zone_free;
+static oshmpi_extents_t oshmpi_zone_used;
+static size_t           oshmpi_zone_page;  /* granularity */
+static size_t           oshmpi_zone_align; /* of regions of at least this size */
+static int              oshmpi_zone_advice = -1; /* that worked to release pages */
+static int              oshmpi_zone_release;     /* the window is shared memory only */
+
+static void oshmpi_extents_insert(oshmpi_extents_t * x, int i, size_t off, size_t len)
+{
+    if (x->n==x->max) {
+        x->max = (x->max>0) ? 2*x->max : 64;
+        x->e   = realloc(x->e, x->max*sizeof(oshmpi_extent_t));
+        assert(x->e!=NULL);
+    }
+    memmove(&x->e[i+1], &x->e[i], (x->n-i)*sizeof(oshmpi_extent_t));
+    x->e[i].off = off;
+    x->e[i].len = len;
+    x->n++;
+}
+
+static void oshmpi_extents_remove(oshmpi_extents_t * x, int i)
+{
+    memmove(&x->e[i], &x->e[i+1], (x->n-i-1)*sizeof(oshmpi_extent_t));
+    x->n--;
+}
+
+/* the first extent at or after off */
+static int oshmpi_extents_search(const oshmpi_extents_t * x, size_t off)
+{
+    int lo = 0, hi = x->n;
+    while (lo<hi) {
+        int mid = (lo+hi)/2;
+        if (x->e[mid].off<off) lo = mid+1;
+        else                   hi = mid;
+    }
+    return lo;
+}
+
+size_t oshmpi_sheap_zone_init(void * base, size_t size)
+{
+    long threshold = oshmpi_getenv_long("OSHMPI_SHEAP_LARGE_THRESHOLD", 0);
+    long zone      = oshmpi_getenv_long("OSHMPI_SHEAP_LARGE_ZONE", (long)(size/2));
+    if (threshold<=0 || zone<=0) {
+        return size;
+    }
+
+    oshmpi_zone_page = (size_t)oshmpi_sheap_page_size;
+    size_t huge = oshmpi_zone_page;
+#if defined(HAVE_LINUX)
+    if (oshmpi_sheap_pages!=OSHMPI_SHEAP_PAGES_HUGETLB &&
+        (size_t)oshmpi_sheap_huge_size(OSHMPI_SHEAP_PAGES_THP)>huge)
+        huge = (size_t)oshmpi_sheap_huge_size(OSHMPI_SHEAP_PAGES_THP);
+#endif
+
+    /* Aligning addresses keeps offsets symmetric only up to the largest
+     * power of two modulo which the heap base is the same on every PE.  The
+     * bits that differ are set in both the OR of the low bits of the base
+     * and the OR of their complement. */
+    unsigned long low[2] = { (unsigned long)base & (huge-1), ~(unsigned long)base & (huge-1) };
+    MPI_Allreduce(MPI_IN_PLACE, low, 2, MPI_UNSIGNED_LONG, MPI_BOR, SHMEM_COMM_WORLD);
+    unsigned long differ = low[0] & low[1];
+    oshmpi_zone_align = (differ==0) ? huge : (size_t)(differ & -differ);
+    if (oshmpi_zone_align<oshmpi_zone_page) {
+        oshmpi_warn("the symmetric heap is not aligned alike on every PE - no large-object zone");
+        return size;
+    }
+
+    /* the top of the heap, whole pages */
+    uintptr_t top = ((uintptr_t)base + size) & ~(uintptr_t)(oshmpi_zone_page-1);
+    uintptr_t bot = (top - (size_t)zone) & ~(uintptr_t)(oshmpi_zone_align-1);
+    if ((size_t)zone>=size || bot<=(uintptr_t)base) {
+        oshmpi_warn("OSHMPI_SHEAP_LARGE_ZONE does not fit in the symmetric heap - no large-object zone");
+        return size;
+    }
+
+    /* as for oshmpi_sheap_release: MPI may have registered the heap with
+     * the network unless it is only reached through shared memory */
+#ifdef ENABLE_SMP_OPTIMIZATIONS
+    oshmpi_zone_release = shmem_world_is_smp;
+#else
+    oshmpi_zone_release = 0;
+#endif
+
+    oshmpi_sheap_large_threshold = (size_t)threshold;
+    oshmpi_sheap_zone_base       = (char*)bot;
+    oshmpi_sheap_zone_size       = (size_t)(top-bot);
+    oshmpi_extents_insert(&oshmpi_zone_free, 0, 0, oshmpi_sheap_zone_size);
+
+#if SHMEM_DEBUG>0
+    if (shmem_world_rank==0) {
+        printf("OSHMPI large-object zone of %zu bytes for allocations of at least %zu bytes, aligned to %zu\n",
+               oshmpi_sheap_zone_size, oshmpi_sheap_large_threshold, oshmpi_zone_align);
+    }
+#endif
+    return (size_t)(bot - (uintptr_t)base);
+}
+
+void oshmpi_sheap_zone_finalize(void)
+{
+    free(oshmpi_zone_free.e);
+    free(oshmpi_zone_used.e);
+    memset(&oshmpi_zone_free, 0, sizeof(oshmpi_extents_t));
+    memset(&oshmpi_zone_used, 0, sizeof(oshmpi_extents_t));
+    oshmpi_sheap_zone_base       = NULL;
+    oshmpi_sheap_zone_size       = 0;
+    oshmpi_sheap_large_threshold = SIZE_MAX;
+}
+
+void * oshmpi_sheap_zone_alloc(size_t size)
+{
+    size_t align = (size>=oshmpi_zone_align) ? oshmpi_zone_align : oshmpi_zone_page;
+    size_t len   = (size + oshmpi_zone_page - 1) & ~(oshmpi_zone_page-1);
+
+    /* from the top down, so that the rest of the zone stays in one piece */
+    for (int i=oshmpi_zone_free.n-1; i>=0; i--) {
+        oshmpi_extent_t f = oshmpi_zone_free.e[i];
+        if (f.len<len) continue;
+        size_t off = (f.off + f.len - len) & ~(align-1);
+        if (off<f.off) continue;
+
+        /* what is left below and above the region */
+        oshmpi_extents_remove(&oshmpi_zone_free, i);
+        if (off+len < f.off+f.len) {
+            oshmpi_extents_insert(&oshmpi_zone_free, i, off+len, f.off+f.len-(off+len));
+        }
+        if (off > f.off) {
+            oshmpi_extents_insert(&oshmpi_zone_free, i, f.off, off-f.off);
+        }
+        oshmpi_extents_insert(&oshmpi_zone_used, oshmpi_extents_search(&oshmpi_zone_used, off), off, len);
+
+        char * ptr = oshmpi_sheap_zone_base + off;
+#if defined(HAVE_LINUX) && defined(MADV_HUGEPAGE)
+        if (len>=oshmpi_zone_align && oshmpi_zone_align>oshmpi_zone_page) {
+            madvise(ptr, len, MADV_HUGEPAGE);
+        }
+#endif
+        return ptr;
+    }
+    return NULL;
+}
+
+size_t oshmpi_sheap_zone_usable_size(const void * ptr)
+{
+    size_t off = (size_t)((const char*)ptr - oshmpi_sheap_zone_base);
+    int i = oshmpi_extents_search(&oshmpi_zone_used, off);
+    if (i==oshmpi_zone_used.n || oshmpi_zone_used.e[i].off!=off) {
+        oshmpi_abort(shmem_world_rank, "shfree: address is not an allocation in the large-object zone");
+    }
+    return oshmpi_zone_used.e[i].len;
+}
+
+/* Gives the pages back to the OS, so they are zero when next touched. */
+static void oshmpi_sheap_zone_release(char * ptr, size_t len)
+{
+    if (!oshmpi_zone_release) return;
+#if defined(HAVE_LINUX)
+#if defined(MADV_REMOVE)
+    /* MADV_DONTNEED would only drop our mapping of a shared page, and
+     * MADV_REMOVE fails on private memory */
+    if (oshmpi_zone_advice!=MADV_DONTNEED) {
+        if (0==madvise(ptr, len, MADV_REMOVE)) {
+            oshmpi_zone_advice = MADV_REMOVE;
+            return;
+        }
+        if (oshmpi_zone_advice==MADV_REMOVE) return;
+        oshmpi_zone_advice = MADV_DONTNEED;
+    }
+#endif
+    madvise(ptr, len, MADV_DONTNEED);
+#else
+    (void)ptr; (void)len;
+#endif
+}
+
+void oshmpi_sheap_zone_free(void * ptr)
+{
+    size_t off = (size_t)((char*)ptr - oshmpi_sheap_zone_base);
+    size_t len = oshmpi_sheap_zone_usable_size(ptr);
+    oshmpi_extents_remove(&oshmpi_zone_used, oshmpi_extents_search(&oshmpi_zone_used, off));
+
+    oshmpi_sheap_zone_release(ptr, len);
+
+    /* coalesce with the free neighbours */
+    int i = oshmpi_extents_search(&oshmpi_zone_free, off);
+    if (i<oshmpi_zone_free.n && oshmpi_zone_free.e[i].off==off+len) {
+        len += oshmpi_zone_free.e[i].len;
+        oshmpi_extents_remove(&oshmpi_zone_free, i);
+    }
+    if (i>0 && oshmpi_zone_free.e[i-1].off+oshmpi_zone_free.e[i-1].len==off) {
+        oshmpi_zone_free.e[i-1].len += len;
+    } else {
+        oshmpi_extents_insert(&oshmpi_zone_free, i, off, len);
+    }
+}
+
+void oshmpi_sheap_zone_stats(size_t * free, size_t * largest)
+{
+    for (int i=0; i<oshmpi_zone_free.n; i++) {
+        *free += oshmpi_zone_free.e[i].len;
+        if (oshmpi_zone_free.e[i].len>*largest) *largest = oshmpi_zone_free.e[i].len;
+    }
+}
@@ -0,0 +1,132 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#ifndef OSHMPI_SHEAP_H
+#define OSHMPI_SHEAP_H
+
+#include "shmem-internals.h"
+
+/* Symmetric heap mapped by OSHMPI rather than allocated by MPI.
+ *
+ * OSHMPI_SHEAP_HUGEPAGES selects one of
+ *   none    - MPI_Win_allocate(_shared) as before (the default)
+ *   thp     - transparent huge pages, via madvise(MADV_HUGEPAGE)
+ *   hugetlb - pages from the hugetlb pool (MAP_HUGETLB or MFD_HUGETLB),
+ *             falling back to thp if the pool is too small
+ * In the SMP case each PE maps its segment from a memfd and the other PEs
+ * on the node map it through /proc/<pid>/fd, which plays the role of
+ * alloc_shared_noncontig.  The memory is then passed to MPI_Win_create.
+ *
+ * OSHMPI_SHEAP_NORESERVE=1 also maps the heap here, with MAP_NORESERVE, so
+ * that only the address space is reserved and pages are committed when they
+ * are first touched.  Large blocks are then given back to the OS on shfree.
+ * All PEs must use the same settings. */
+
+enum oshmpi_sheap_pages_e { OSHMPI_SHEAP_PAGES_DEFAULT = 0,
+                            OSHMPI_SHEAP_PAGES_THP     = 1,
+                            OSHMPI_SHEAP_PAGES_HUGETLB = 2 };
+
+extern int  oshmpi_sheap_pages;     /* what was obtained, not what was asked for */
+extern long oshmpi_sheap_page_size; /* in bytes */
+
+/* Collective.  Returns 1 if the heap was mapped and its window created,
+ * with the load-store address of every PE in *smp_ptrs when is_smp, or 0
+ * if the caller should allocate the heap with MPI. */
+int oshmpi_sheap_create(MPI_Aint size, MPI_Info info, int is_smp,
+                        void ** base, MPI_Win * win, void *** smp_ptrs);
+
+/* after the window has been freed */
+void oshmpi_sheap_destroy(void);
+
+/* With OSHMPI_SHEAP_NORESERVE on a single node, shfree returns the pages of a
+ * freed block of at least this many bytes to the OS.  SIZE_MAX otherwise. */
+extern size_t oshmpi_sheap_release_threshold;
+
+/* ptr and size are the block that is about to be given back to dlmalloc,
+ * with the heap lock held */
+void oshmpi_sheap_release(void * ptr, size_t size);
+
+/* Growable heap.
+ *
+ * With OSHMPI_SHEAP_GROWABLE=1, an allocation that does not fit in the
+ * heap adds a segment of at least OSHMPI_SHEAP_SEGMENT_SIZE bytes (default:
+ * the initial heap size) with its own window, and allocates from it.
+ * Symmetric allocation means that every PE runs out at the same call, so
+ * growing is collective like the allocation routines themselves.  The
+ * initial heap is always tried first and is found without a table lookup;
+ * addresses in added segments are found by binary search. */
+
+extern int oshmpi_sheap_growable;
+
+void oshmpi_sheap_segments_init(void);
+/* before the initial heap window is freed */
+void oshmpi_sheap_segments_finalize(void);
+
+/* Allocation that did not fit in the initial heap.  Returns NULL if the
+ * heap cannot grow. */
+void * oshmpi_sheap_segment_alloc(size_t alignment, size_t size);
+void * oshmpi_sheap_segment_realloc(void * ptr, size_t size);
+/* ptr is not in the initial heap */
+void   oshmpi_sheap_segment_free(void * ptr);
+
+/* Collective.  Adds a segment of at least size bytes with its own window,
+ * created with hints (may be MPI_INFO_NULL) and OSHMPI_SEGMENT_* flags,
+ * and returns its index, or -1 if there are too many. */
+int    oshmpi_sheap_segment_create(size_t size, MPI_Info hints, int flags);
+/* Collective.  The indices of later segments go down by one. */
+void   oshmpi_sheap_segment_destroy(int i);
+
+/* Bytes allocated by shmalloc and friends in the heap and its segments, but
+ * not spaces, and the most there have been.  Updated with the heap lock
+ * held whenever dlmalloc allocates or frees a block, so blocks kept by the
+ * allocation cache count as allocated. */
+extern size_t oshmpi_sheap_in_use;
+extern size_t oshmpi_sheap_high_water;
+
+static inline void oshmpi_sheap_count_alloc(size_t size)
+{
+    oshmpi_sheap_in_use += size;
+    if (oshmpi_sheap_in_use>oshmpi_sheap_high_water) {
+        oshmpi_sheap_high_water = oshmpi_sheap_in_use;
+    }
+}
+
+static inline void oshmpi_sheap_count_free(size_t size)
+{
+    oshmpi_sheap_in_use -= size;
+}
+
+static inline int oshmpi_sheap_is_initial(const void * ptr)
+{
+    return ((uintptr_t)ptr - (uintptr_t)shmem_sheap_base_ptr) < (uintptr_t)shmem_sheap_size;
+}
+
+/* Large-object zone.
+ *
+ * With OSHMPI_SHEAP_LARGE_THRESHOLD set, allocations of at least that many
+ * bytes come from a zone of OSHMPI_SHEAP_LARGE_ZONE bytes (default half
+ * the heap) at the top of the initial heap, and dlmalloc gets the rest.
+ * Regions are whole pages, aligned to the huge page size if they are at
+ * least that large (as far as the heap is aligned on every PE), and their
+ * pages are given back to the OS on shfree if all PEs are on one node.
+ * When the zone is full, large allocations fall back to dlmalloc. */
+
+extern size_t oshmpi_sheap_large_threshold; /* SIZE_MAX if there is no zone */
+extern char * oshmpi_sheap_zone_base;
+extern size_t oshmpi_sheap_zone_size;
+
+/* Collective.  Returns how much of the heap at base is left for dlmalloc. */
+size_t oshmpi_sheap_zone_init(void * base, size_t size);
+void   oshmpi_sheap_zone_finalize(void);
+
+/* with the heap lock held */
+void * oshmpi_sheap_zone_alloc(size_t size);
+void   oshmpi_sheap_zone_free(void * ptr);
+size_t oshmpi_sheap_zone_usable_size(const void * ptr);
+void   oshmpi_sheap_zone_stats(size_t * free, size_t * largest);
+
+static inline int oshmpi_sheap_in_zone(const void * ptr)
+{
+    return ((uintptr_t)ptr - (uintptr_t)oshmpi_sheap_zone_base) < (uintptr_t)oshmpi_sheap_zone_size;
+}
+
+#endif /* OSHMPI_SHEAP_H */
@@ -0,0 +1,229 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#define _GNU_SOURCE /* sched_setaffinity, sched_getcpu */
+
+#include "oshmpi-topo.h"
+
+#include <unistd.h>
+#if defined(HAVE_LINUX)
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+int   oshmpi_topo_bind;
+int   oshmpi_topo_num_numa;
+int   oshmpi_topo_numa;
+int * oshmpi_topo_pe_numa;
+
+static const char * oshmpi_topo_bind_names[] = { "none", "core", "numa" };
+
+#if defined(HAVE_LINUX)
+
+/* from linux/mempolicy.h, which is not always installed */
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+#ifndef MPOL_MF_MOVE
+#define MPOL_MF_MOVE   (1<<1)
+#endif
+
+#define OSHMPI_TOPO_MAX_CPUS 4096
+
+/* Parses a sysfs list such as "0-3,8-11" into a mask of n bits.
+ * Returns the number of bits set, or -1 if the file cannot be read. */
+static int oshmpi_topo_read_list(const char * path, cpu_set_t * set)
+{
+    FILE * f = fopen(path, "r");
+    if (f==NULL) return -1;
+
+    CPU_ZERO(set);
+    int count = 0, lo, hi;
+    char sep;
+    while (fscanf(f, "%d", &lo)==1) {
+        hi = lo;
+        sep = (char)fgetc(f);
+        if (sep=='-') {
+            if (fscanf(f, "%d", &hi)!=1) break;
+            sep = (char)fgetc(f);
+        }
+        for (int i=lo; i<=hi && i<CPU_SETSIZE; i++) {
+            CPU_SET(i, set);
+            count++;
+        }
+        if (sep!=',') break;
+    }
+    fclose(f);
+    return count;
+}
+
+static int oshmpi_topo_cpu_numa(int cpu)
+{
+    for (int n=0; n<oshmpi_topo_num_numa; n++) {
+        char path[128];
+        cpu_set_t set;
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+        if (oshmpi_topo_read_list(path, &set)>0 && CPU_ISSET(cpu, &set))
+            return n;
+    }
+    return -1;
+}
+
+static void oshmpi_topo_bind_self(int node_rank, int node_size)
+{
+    cpu_set_t allowed, set;
+    if (0!=sched_getaffinity(0, sizeof(allowed), &allowed)) {
+        oshmpi_warn("OSHMPI_BIND: sched_getaffinity failed - not binding");
+        return;
+    }
+
+    if (oshmpi_topo_bind==OSHMPI_BIND_CORE) {
+        int nallowed = CPU_COUNT(&allowed), target = node_rank % nallowed, cpu = -1;
+        for (int i=0, k=0; i<CPU_SETSIZE; i++) {
+            if (CPU_ISSET(i, &allowed) && k++==target) {
+                cpu = i;
+                break;
+            }
+        }
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (0!=sched_setaffinity(0, sizeof(set), &set)) {
+            oshmpi_warn("OSHMPI_BIND: sched_setaffinity failed");
+            return;
+        }
+        oshmpi_topo_numa = oshmpi_topo_cpu_numa(cpu);
+    } else {
+        /* the first node_size/num_numa PEs on the first domain, and so on */
+        int numa = (int)((long)node_rank * oshmpi_topo_num_numa / node_size);
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", numa);
+        if (oshmpi_topo_read_list(path, &set)<=0) {
+            oshmpi_warn("OSHMPI_BIND: no CPUs found for NUMA domain - not binding");
+            return;
+        }
+        /* stay inside what the launcher gave us, if that overlaps */
+        cpu_set_t both;
+        CPU_AND(&both, &set, &allowed);
+        if (CPU_COUNT(&both)>0) set = both;
+        if (0!=sched_setaffinity(0, sizeof(set), &set)) {
+            oshmpi_warn("OSHMPI_BIND: sched_setaffinity failed");
+            return;
+        }
+        oshmpi_topo_numa = numa;
+    }
+}
+
+#endif /* HAVE_LINUX */
+
+void oshmpi_topo_init(void)
+{
+    oshmpi_topo_bind     = OSHMPI_BIND_NONE;
+    oshmpi_topo_num_numa = 1;
+    oshmpi_topo_numa     = -1;
+    oshmpi_topo_pe_numa  = NULL;
+
+    char * env_char = getenv("OSHMPI_BIND");
+    if (env_char!=NULL) {
+        for (int i=0; i<3; i++) {
+            if (0==strcmp(env_char, oshmpi_topo_bind_names[i])) {
+                oshmpi_topo_bind = i;
+            }
+        }
+        if (oshmpi_topo_bind==OSHMPI_BIND_NONE && 0!=strcmp(env_char, "none")) {
+            oshmpi_warn("OSHMPI_BIND is not one of none, core or numa - using none");
+        }
+    }
+
+#if !defined(EXTENSION_TOPOLOGY)
+    /* nothing to do and nobody to tell */
+    if (oshmpi_topo_bind==OSHMPI_BIND_NONE) return;
+#endif
+
+    int node_rank, node_size, node_leader;
+#ifdef ENABLE_SMP_OPTIMIZATIONS
+    node_rank   = shmem_node_rank;
+    node_size   = shmem_node_size;
+    node_leader = shmem_smp_rank_list[0];
+#else
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(SHMEM_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0 /* key */, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, &node_rank);
+    MPI_Comm_size(node_comm, &node_size);
+    node_leader = shmem_world_rank;
+    MPI_Bcast(&node_leader, 1, MPI_INT, 0, node_comm);
+    MPI_Comm_free(&node_comm);
+#endif
+
+#if defined(HAVE_LINUX)
+    {
+        cpu_set_t nodes;
+        int n = oshmpi_topo_read_list("/sys/devices/system/node/online", &nodes);
+        if (n>0) oshmpi_topo_num_numa = n;
+    }
+
+    if (oshmpi_topo_bind!=OSHMPI_BIND_NONE) {
+        oshmpi_topo_bind_self(node_rank, node_size);
+    }
+    if (oshmpi_topo_numa<0) {
+        int cpu = sched_getcpu();
+        if (cpu>=0) oshmpi_topo_numa = oshmpi_topo_cpu_numa(cpu);
+    }
+#else
+    if (oshmpi_topo_bind!=OSHMPI_BIND_NONE) {
+        oshmpi_warn("OSHMPI_BIND is only supported on Linux");
+        oshmpi_topo_bind = OSHMPI_BIND_NONE;
+    }
+#endif
+
+#if defined(EXTENSION_TOPOLOGY)
+    {
+        int me[2] = { node_leader, oshmpi_topo_numa };
+        int * all = malloc(2*shmem_world_size*sizeof(int)); assert(all!=NULL);
+        MPI_Allgather(me, 2, MPI_INT, all, 2, MPI_INT, SHMEM_COMM_WORLD);
+        oshmpi_topo_pe_numa = malloc(shmem_world_size*sizeof(int)); assert(oshmpi_topo_pe_numa!=NULL);
+        for (int i=0; i<shmem_world_size; i++)
+            oshmpi_topo_pe_numa[i] = (all[2*i]==node_leader) ? all[2*i+1] : -1;
+        free(all);
+    }
+#else
+    (void)node_leader;
+#endif
+
+#if SHMEM_DEBUG>0
+    printf("[%d] OSHMPI_BIND=%s, NUMA domain %d of %d\n", shmem_world_rank,
+           oshmpi_topo_bind_names[oshmpi_topo_bind], oshmpi_topo_numa, oshmpi_topo_num_numa);
+#endif
+}
+
+void oshmpi_topo_finalize(void)
+{
+    free(oshmpi_topo_pe_numa);
+    oshmpi_topo_pe_numa = NULL;
+}
+
+void oshmpi_topo_bind_memory(void * base, size_t size)
+{
+#if defined(HAVE_LINUX) && defined(SYS_mbind)
+    if (oshmpi_topo_bind==OSHMPI_BIND_NONE || oshmpi_topo_numa<0 || oshmpi_topo_num_numa<2) {
+        return;
+    }
+
+    /* only whole pages, since a segment may share its first or last page
+     * with the segment of another PE */
+    uintptr_t page  = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t)base + page - 1) & ~(page-1);
+    uintptr_t stop  = ((uintptr_t)base + size) & ~(page-1);
+    if (stop<=start) return;
+
+    unsigned long mask[OSHMPI_TOPO_MAX_CPUS/(8*sizeof(unsigned long))] = {0};
+    if (oshmpi_topo_numa>=OSHMPI_TOPO_MAX_CPUS) return;
+    mask[oshmpi_topo_numa/(8*sizeof(unsigned long))] |= 1UL << (oshmpi_topo_numa%(8*sizeof(unsigned long)));
+
+    /* preferred rather than bind so that a full domain spills instead of failing */
+    if (0!=syscall(SYS_mbind, (void*)start, stop-start, MPOL_PREFERRED, mask,
+                   (unsigned long)OSHMPI_TOPO_MAX_CPUS, MPOL_MF_MOVE)) {
+        oshmpi_warn("OSHMPI_BIND: mbind of the symmetric heap failed");
+    }
+#else
+    (void)base; (void)size;
+#endif
+}
@@ -0,0 +1,35 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#ifndef OSHMPI_TOPO_H
+#define OSHMPI_TOPO_H
+
+#include "shmem-internals.h"
+
+/* Node topology and PE placement.
+ *
+ * OSHMPI_BIND selects one of
+ *   none - leave placement to the launcher (the default)
+ *   core - bind the i-th PE on a node to the i-th CPU it may run on
+ *   numa - bind PEs to NUMA domains in blocks of consecutive node ranks
+ * When PEs are bound, each PE's segment of the symmetric heap is bound to
+ * its NUMA domain with mbind, so the first touch by whichever PE does not
+ * decide where it lives.  The NUMA domain of every PE is available through
+ * the topology extension. */
+
+enum oshmpi_bind_e { OSHMPI_BIND_NONE = 0,
+                     OSHMPI_BIND_CORE = 1,
+                     OSHMPI_BIND_NUMA = 2 };
+
+extern int   oshmpi_topo_bind;
+extern int   oshmpi_topo_num_numa;  /* NUMA domains on this node */
+extern int   oshmpi_topo_numa;      /* the domain of this PE, or -1 if unknown */
+extern int * oshmpi_topo_pe_numa;   /* per PE, -1 if on another node; NULL if not gathered */
+
+/* Collective.  Before the symmetric heap is allocated. */
+void oshmpi_topo_init(void);
+void oshmpi_topo_finalize(void);
+
+/* Binds the pages in [base,base+size) to the NUMA domain of this PE. */
+void oshmpi_topo_bind_memory(void * base, size_t size);
+
+#endif /* OSHMPI_TOPO_H */
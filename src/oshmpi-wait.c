@@ -0,0 +1,231 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#include "oshmpi-wait.h"
+
+#include <sched.h>
+#include <time.h>
+#include <limits.h>
+#if defined(HAVE_LINUX)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+int                  oshmpi_wait_policy;
+int                  oshmpi_wait_can_block;
+shmem_offset_t       oshmpi_wait_word_offset;
+oshmpi_wait_word_t * oshmpi_wait_word;
+
+/* Upper bound on the number of pause instructions between two polls. */
+#define OSHMPI_WAIT_BACKOFF_MAX 1024
+
+static long   oshmpi_wait_spin_budget;  /* in pause instructions */
+static double oshmpi_wait_yield_time;   /* in seconds */
+static long   oshmpi_wait_block_usec;
+static int    oshmpi_wait_stats;
+
+static double oshmpi_wait_phase_time[OSHMPI_WAIT_PHASE_COUNT];
+static long   oshmpi_wait_count;
+static long   oshmpi_wait_sleeps;
+
+static const char * oshmpi_wait_policy_names[] = { "spin", "yield", "block", "adaptive" };
+
+void oshmpi_wait_policy_init(int ppn)
+{
+    char * env_char = getenv("OSHMPI_WAIT_POLICY");
+    if (env_char!=NULL) {
+        oshmpi_wait_policy = -1;
+        for (int i=0; i<4; i++) {
+            if (0==strcmp(env_char, oshmpi_wait_policy_names[i])) {
+                oshmpi_wait_policy = i;
+            }
+        }
+        if (oshmpi_wait_policy<0) {
+            oshmpi_warn("OSHMPI_WAIT_POLICY is not one of spin, yield, block or adaptive - using spin");
+            oshmpi_wait_policy = OSHMPI_WAIT_SPIN;
+        }
+    } else {
+        /* Spinning is only harmful when PEs compete for cores. */
+        long ncores = sysconf(_SC_NPROCESSORS_ONLN);
+        oshmpi_wait_policy = (ncores>0 && ppn>ncores) ? OSHMPI_WAIT_ADAPTIVE : OSHMPI_WAIT_SPIN;
+    }
+
+    long spin_usec         = oshmpi_getenv_long("OSHMPI_WAIT_SPIN_USEC", 100);
+    long yield_usec        = oshmpi_getenv_long("OSHMPI_WAIT_YIELD_USEC", 1000);
+    oshmpi_wait_block_usec = oshmpi_getenv_long("OSHMPI_WAIT_BLOCK_USEC", 1000);
+    oshmpi_wait_stats      = oshmpi_getenv_long("OSHMPI_WAIT_STATS", 0);
+
+    oshmpi_wait_yield_time = 1.e-6 * yield_usec;
+    if (oshmpi_wait_block_usec<1) oshmpi_wait_block_usec = 1;
+
+    /* Calibrate the spin budget, since the latency of pause varies by more
+     * than an order of magnitude across processors. */
+    {
+        const long n = 4096;
+        double t0 = MPI_Wtime();
+        for (long i=0; i<n; i++)
+            OSHMPI_CPU_RELAX();
+        double t1 = MPI_Wtime();
+        double relax_per_usec = (t1>t0) ? n/(1.e6*(t1-t0)) : (double)n;
+        oshmpi_wait_spin_budget = (long)(spin_usec * relax_per_usec);
+    }
+
+    oshmpi_wait_can_block = (oshmpi_wait_policy==OSHMPI_WAIT_BLOCK || oshmpi_wait_policy==OSHMPI_WAIT_ADAPTIVE);
+}
+
+void oshmpi_wait_init(void)
+{
+    /* Every PE allocates this first, so it has the same offset everywhere. */
+    oshmpi_wait_word = mspace_memalign(shmem_heap_mspace, 64, sizeof(oshmpi_wait_word_t));
+    assert(oshmpi_wait_word!=NULL);
+    oshmpi_wait_word->seq     = 0;
+    oshmpi_wait_word->waiters = 0;
+    oshmpi_wait_word_offset = (intptr_t)oshmpi_wait_word - (intptr_t)shmem_sheap_base_ptr;
+
+#if SHMEM_DEBUG>0
+    if (shmem_world_rank==0) {
+        printf("OSHMPI wait policy is %s (spin budget %ld)\n",
+               oshmpi_wait_policy_names[oshmpi_wait_policy], oshmpi_wait_spin_budget);
+    }
+#endif
+}
+
+void oshmpi_wait_finalize(void)
+{
+    if (oshmpi_wait_stats) {
+        /* waits, sleeps, spin, yield, block */
+        double in[5] = { (double)oshmpi_wait_count, (double)oshmpi_wait_sleeps,
+                         oshmpi_wait_phase_time[OSHMPI_WAIT_PHASE_SPIN],
+                         oshmpi_wait_phase_time[OSHMPI_WAIT_PHASE_YIELD],
+                         oshmpi_wait_phase_time[OSHMPI_WAIT_PHASE_BLOCK] };
+        double sum[5], max[5];
+        MPI_Reduce(in, sum, 5, MPI_DOUBLE, MPI_SUM, 0, SHMEM_COMM_WORLD);
+        MPI_Reduce(in, max, 5, MPI_DOUBLE, MPI_MAX, 0, SHMEM_COMM_WORLD);
+        if (shmem_world_rank==0) {
+            printf("OSHMPI wait policy %s: %.0f waits, %.0f sleeps\n",
+                   oshmpi_wait_policy_names[oshmpi_wait_policy], sum[0], sum[1]);
+            printf("OSHMPI wait time (s)  spin: total %lf max %lf  yield: total %lf max %lf  block: total %lf max %lf\n",
+                   sum[2], max[2], sum[3], max[3], sum[4], max[4]);
+            fflush(stdout);
+        }
+    }
+    mspace_free(shmem_heap_mspace, oshmpi_wait_word);
+    oshmpi_wait_word = NULL;
+}
+
+static inline void oshmpi_wait_progress(void)
+{
+    /* lets implementations with software RMA make progress */
+    int flag;
+    MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, SHMEM_COMM_WORLD, &flag, MPI_STATUS_IGNORE);
+}
+
+static void oshmpi_wait_next_phase(oshmpi_wait_t * w, int phase)
+{
+    double t = MPI_Wtime();
+    if (oshmpi_wait_stats) {
+        oshmpi_wait_phase_time[w->phase] += t - w->t_phase;
+    }
+    w->phase   = phase;
+    w->t_phase = t;
+}
+
+void oshmpi_wait_begin(oshmpi_wait_t * w)
+{
+    w->phase      = (oshmpi_wait_policy==OSHMPI_WAIT_BLOCK) ? OSHMPI_WAIT_PHASE_BLOCK : OSHMPI_WAIT_PHASE_SPIN;
+    w->registered = 0;
+    w->seq        = 0;
+    w->backoff    = 0;
+    w->spins      = 0;
+    w->t_phase    = oshmpi_wait_stats ? MPI_Wtime() : 0.0;
+}
+
+void oshmpi_wait_end(oshmpi_wait_t * w)
+{
+    if (w->registered) {
+        __sync_fetch_and_sub(&oshmpi_wait_word->waiters, 1);
+    }
+    if (oshmpi_wait_stats) {
+        oshmpi_wait_phase_time[w->phase] += MPI_Wtime() - w->t_phase;
+        oshmpi_wait_count++;
+    }
+}
+
+static void oshmpi_wait_block(oshmpi_wait_t * w)
+{
+    oshmpi_wait_word_t * word = oshmpi_wait_word;
+
+    if (!w->registered) {
+        /* The caller checks its condition again after this, so a writer
+         * either sees us in waiters or we see its store. */
+        __sync_fetch_and_add(&word->waiters, 1);
+        w->registered = 1;
+        w->seq = word->seq;
+        return;
+    }
+
+    struct timespec ts = { oshmpi_wait_block_usec/1000000, 1000*(oshmpi_wait_block_usec%1000000) };
+#if defined(HAVE_LINUX)
+    /* not FUTEX_PRIVATE_FLAG because the word is in memory shared with other PEs */
+    syscall(SYS_futex, &word->seq, FUTEX_WAIT, w->seq, &ts, NULL, 0);
+#else
+    nanosleep(&ts, NULL);
+#endif
+    oshmpi_wait_sleeps++;
+    w->seq = word->seq;
+    oshmpi_wait_progress();
+}
+
+int oshmpi_wait_backoff(oshmpi_wait_t * w)
+{
+    int phase = w->phase;
+
+    switch (w->phase) {
+        case OSHMPI_WAIT_PHASE_SPIN:
+            for (int i=0; i<w->backoff; i++)
+                OSHMPI_CPU_RELAX();
+            w->spins += w->backoff;
+
+            if (w->backoff < OSHMPI_WAIT_BACKOFF_MAX) {
+                w->backoff = 2*w->backoff+1;
+            } else {
+                oshmpi_wait_progress();
+            }
+
+            if (oshmpi_wait_policy!=OSHMPI_WAIT_SPIN && w->spins>=oshmpi_wait_spin_budget) {
+                oshmpi_wait_next_phase(w, OSHMPI_WAIT_PHASE_YIELD);
+            }
+            break;
+
+        case OSHMPI_WAIT_PHASE_YIELD:
+            sched_yield();
+            oshmpi_wait_progress();
+            if (oshmpi_wait_policy==OSHMPI_WAIT_ADAPTIVE && MPI_Wtime()-w->t_phase > oshmpi_wait_yield_time) {
+                oshmpi_wait_next_phase(w, OSHMPI_WAIT_PHASE_BLOCK);
+            }
+            break;
+
+        case OSHMPI_WAIT_PHASE_BLOCK:
+            oshmpi_wait_block(w);
+            break;
+    }
+    return w->phase!=phase;
+}
+
+void oshmpi_wait_poll(oshmpi_wait_t * w)
+{
+    oshmpi_wait_backoff(w);
+
+    /* MPI_Win_sync is required for the private copy of the window to observe
+     * remote updates (it is only a memory barrier in the UNIFIED model). */
+    oshmpi_local_sync();
+    oshmpi_etext_poll();
+}
+
+void oshmpi_wait_wake_word(oshmpi_wait_word_t * word)
+{
+    __sync_fetch_and_add(&word->seq, 1);
+#if defined(HAVE_LINUX)
+    syscall(SYS_futex, &word->seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+}
@@ -0,0 +1,92 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#ifndef OSHMPI_WAIT_H
+#define OSHMPI_WAIT_H
+
+#include "shmem-internals.h"
+
+/* Wait policy engine for all the loops that poll local symmetric memory.
+ *
+ * OSHMPI_WAIT_POLICY selects one of
+ *   spin     - poll with exponential backoff (pause instructions) forever
+ *   yield    - spin for OSHMPI_WAIT_SPIN_USEC, then sched_yield between polls
+ *   block    - sleep on a futex word in the symmetric heap between polls
+ *   adaptive - spin, then yield for OSHMPI_WAIT_YIELD_USEC, then block
+ * The default is spin, or adaptive if there are more PEs than cores on the node.
+ *
+ * Blocked PEs are woken by intranode writers that use the SMP bypass, and
+ * by the PE that asks for the lazy etext window when all PEs share a node.
+ * Writers that go through MPI to another node cannot reach the futex, so a
+ * PE waiting on them, or on an etext request from another node, only sees
+ * the update when the futex wait times out after OSHMPI_WAIT_BLOCK_USEC
+ * and the condition is polled again.
+ * OSHMPI_WAIT_STATS=1 reports the time spent in each phase at finalize. */
+
+enum oshmpi_wait_policy_e { OSHMPI_WAIT_SPIN     = 0,
+                            OSHMPI_WAIT_YIELD    = 1,
+                            OSHMPI_WAIT_BLOCK    = 2,
+                            OSHMPI_WAIT_ADAPTIVE = 3 };
+
+enum oshmpi_wait_phase_e { OSHMPI_WAIT_PHASE_SPIN  = 0,
+                           OSHMPI_WAIT_PHASE_YIELD = 1,
+                           OSHMPI_WAIT_PHASE_BLOCK = 2,
+                           OSHMPI_WAIT_PHASE_COUNT = 3 };
+
+/* One per PE, at the same offset in every symmetric heap. */
+typedef struct oshmpi_wait_word_s
+{
+  volatile int seq;     /* futex word, bumped by writers that wake us */
+  volatile int waiters; /* number of threads of this PE in the block phase */
+} oshmpi_wait_word_t;
+
+/* Per-call state, lives on the stack of the waiting thread. */
+typedef struct oshmpi_wait_s
+{
+  int    phase;
+  int    registered; /* counted in waiters */
+  int    seq;        /* value of seq observed before the last condition check */
+  int    backoff;    /* pause instructions between polls */
+  long   spins;      /* pause instructions executed so far */
+  double t_phase;    /* start of the current phase */
+} oshmpi_wait_t;
+
+extern int                  oshmpi_wait_policy;
+extern int                  oshmpi_wait_can_block;
+extern shmem_offset_t       oshmpi_wait_word_offset;
+extern oshmpi_wait_word_t * oshmpi_wait_word;
+
+/* Parses OSHMPI_WAIT_POLICY for ppn PEs on this node and sets
+ * oshmpi_wait_can_block for this PE only; oshmpi_initialize reduces it
+ * across PEs with the rest of what they agree on. */
+void oshmpi_wait_policy_init(int ppn);
+/* Allocates from the symmetric heap, so must be the first to do so. */
+void oshmpi_wait_init(void);
+void oshmpi_wait_finalize(void);
+
+void oshmpi_wait_begin(oshmpi_wait_t * w);
+/* Backs off according to the phase, then syncs the windows. */
+void oshmpi_wait_poll(oshmpi_wait_t * w);
+/* Only backs off, and returns nonzero if that moved to the next phase, for
+ * loops that read a volatile word and sync the windows only then. */
+int  oshmpi_wait_backoff(oshmpi_wait_t * w);
+void oshmpi_wait_end(oshmpi_wait_t * w);
+
+void oshmpi_wait_wake_word(oshmpi_wait_word_t * word);
+
+/* Called after an intranode store to the symmetric heap of pe.
+ * The common case is that nobody blocks, which costs one branch. */
+static inline void oshmpi_wait_wake(int pe)
+{
+#ifdef ENABLE_SMP_OPTIMIZATIONS
+    if (unlikely(oshmpi_wait_can_block)) {
+        oshmpi_wait_word_t * word = (oshmpi_wait_word_t*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + oshmpi_wait_word_offset );
+        /* order the store that satisfies the waiter before the read of waiters */
+        __sync_synchronize();
+        if (word->waiters > 0)
+            oshmpi_wait_wake_word(word);
+    }
+#endif
+    (void)pe;
+}
+
+#endif /* OSHMPI_WAIT_H */
@@ -0,0 +1,162 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#ifndef OSHMPI_SHMEM_INLINE_H
+#define OSHMPI_SHMEM_INLINE_H
+
+/* Included at the end of shmem.h.
+ *
+ * Compiling an application with -DOSHMPI_INLINE replaces the out-of-line
+ * elemental put/get and integer AMO routines with static inline definitions.
+ * When the target is in the symmetric heap of a PE that can be reached by
+ * load-store, these are a bounds check, a table lookup and one typed
+ * load, store or __sync atomic, which the compiler can inline into the
+ * caller's loop.  Everything else calls into the library as before.
+ *
+ * The library is built with OSHMPI_BUILDING_LIBRARY, which ignores
+ * OSHMPI_INLINE, so applications compiled either way link against the
+ * same libshmem. */
+
+/* Filled in by the library at initialization. */
+typedef struct oshmpi_inline_state_s
+{
+    void ** smp_ptrs;   /* NULL unless every PE is reachable by load-store */
+    char *  sheap_base; /* local base of the symmetric heap */
+    size_t  sheap_size;
+    int     can_block;  /* some PE may sleep in a wait routine */
+    size_t  eager_threshold; /* puts up to this many bytes are buffered */
+} oshmpi_inline_state_t;
+
+extern oshmpi_inline_state_t oshmpi_inline_state;
+
+/* wake PEs sleeping on pe after a load-store update (out of line, rare) */
+void oshmpi_inline_wake(int pe);
+
+#if OSHMPI_HAVE_INLINE
+
+#include "shmem-types.h"
+
+/* Same prototypes as shmem-internals.h, used for the slow path. */
+void oshmpi_put(MPI_Datatype mpi_type, void *target, const void *source, size_t len, int pe);
+void oshmpi_put_eager(void *target, const void *source, size_t len, int pe);
+void oshmpi_get(MPI_Datatype mpi_type, void *target, const void *source, size_t len, int pe);
+void oshmpi_swap(MPI_Datatype mpi_type, void *output, void *remote, const void *input, int pe);
+void oshmpi_cswap(MPI_Datatype mpi_type, void *output, void *remote, const void *input, const void *compare, int pe);
+void oshmpi_add(MPI_Datatype mpi_type, void *remote, const void *input, int pe);
+void oshmpi_fadd(MPI_Datatype mpi_type, void *output, void *remote, const void *input, int pe);
+
+/* Returns the load-store address of addr at pe, or NULL if there is none. */
+static inline void * oshmpi_inline_ptr(const void * addr, int pe)
+{
+    size_t offset = (size_t)((uintptr_t)addr - (uintptr_t)oshmpi_inline_state.sheap_base);
+    if (__builtin_expect(oshmpi_inline_state.smp_ptrs!=NULL && offset<oshmpi_inline_state.sheap_size, 1)) {
+        return (char*)oshmpi_inline_state.smp_ptrs[pe] + offset;
+    }
+    return NULL;
+}
+
+static inline void oshmpi_inline_wake_check(int pe)
+{
+    if (__builtin_expect(oshmpi_inline_state.can_block, 0))
+        oshmpi_inline_wake(pe);
+}
+
+#define OSHMPI_INLINE_P(NAME, TYPE, MPI_TYPE)                               \
+    static inline void shmem_##NAME##_p(TYPE *addr, TYPE value, int pe)     \
+    {                                                                       \
+        TYPE * ptr = (TYPE*)oshmpi_inline_ptr(addr, pe);                    \
+        if (ptr!=NULL) {                                                    \
+            *(volatile TYPE *)ptr = value;                                  \
+            oshmpi_inline_wake_check(pe);                                   \
+        } else if (sizeof(TYPE)<=oshmpi_inline_state.eager_threshold) {     \
+            oshmpi_put_eager(addr, &value, sizeof(TYPE), pe);               \
+        } else {                                                            \
+            oshmpi_put(MPI_TYPE, addr, &value, 1, pe);                      \
+        }                                                                   \
+    }
+
+#define OSHMPI_INLINE_G(NAME, TYPE, MPI_TYPE)                               \
+    static inline TYPE shmem_##NAME##_g(TYPE *addr, int pe)                 \
+    {                                                                       \
+        TYPE * ptr = (TYPE*)oshmpi_inline_ptr(addr, pe);                    \
+        TYPE value;                                                         \
+        if (ptr!=NULL) {                                                    \
+            value = *(volatile TYPE *)ptr;                                  \
+        } else {                                                            \
+            oshmpi_get(MPI_TYPE, &value, addr, 1, pe);                      \
+        }                                                                   \
+        return value;                                                       \
+    }
+
+/* Only the integer types, which have __sync builtins. */
+#define OSHMPI_INLINE_AMO(NAME, TYPE, MPI_TYPE)                             \
+    static inline TYPE shmem_##NAME##_swap(TYPE *target, TYPE value, int pe) \
+    {                                                                       \
+        TYPE * ptr = (TYPE*)oshmpi_inline_ptr(target, pe);                  \
+        TYPE r;                                                             \
+        if (ptr!=NULL) {                                                    \
+            r = __sync_lock_test_and_set(ptr, value);                       \
+            oshmpi_inline_wake_check(pe);                                   \
+        } else {                                                            \
+            oshmpi_swap(MPI_TYPE, &r, target, &value, pe);                  \
+        }                                                                   \
+        return r;                                                           \
+    }                                                                       \
+    static inline TYPE shmem_##NAME##_cswap(TYPE *target, TYPE cond, TYPE value, int pe) \
+    {                                                                       \
+        TYPE * ptr = (TYPE*)oshmpi_inline_ptr(target, pe);                  \
+        TYPE r;                                                             \
+        if (ptr!=NULL) {                                                    \
+            r = __sync_val_compare_and_swap(ptr, cond, value);              \
+            oshmpi_inline_wake_check(pe);                                   \
+        } else {                                                            \
+            oshmpi_cswap(MPI_TYPE, &r, target, &value, &cond, pe);          \
+        }                                                                   \
+        return r;                                                           \
+    }                                                                       \
+    static inline TYPE shmem_##NAME##_fadd(TYPE *target, TYPE value, int pe) \
+    {                                                                       \
+        TYPE * ptr = (TYPE*)oshmpi_inline_ptr(target, pe);                  \
+        TYPE r;                                                             \
+        if (ptr!=NULL) {                                                    \
+            r = __sync_fetch_and_add(ptr, value);                           \
+            oshmpi_inline_wake_check(pe);                                   \
+        } else {                                                            \
+            oshmpi_fadd(MPI_TYPE, &r, target, &value, pe);                  \
+        }                                                                   \
+        return r;                                                           \
+    }                                                                       \
+    static inline TYPE shmem_##NAME##_finc(TYPE *target, int pe)            \
+    {                                                                       \
+        return shmem_##NAME##_fadd(target, 1, pe);                          \
+    }                                                                       \
+    static inline void shmem_##NAME##_add(TYPE *target, TYPE value, int pe) \
+    {                                                                       \
+        TYPE * ptr = (TYPE*)oshmpi_inline_ptr(target, pe);                  \
+        if (ptr!=NULL) {                                                    \
+            __sync_fetch_and_add(ptr, value);                               \
+            oshmpi_inline_wake_check(pe);                                   \
+        } else {                                                            \
+            oshmpi_add(MPI_TYPE, target, &value, pe);                       \
+        }                                                                   \
+    }                                                                       \
+    static inline void shmem_##NAME##_inc(TYPE *target, int pe)             \
+    {                                                                       \
+        shmem_##NAME##_add(target, 1, pe);                                  \
+    }
+
+OSHMPI_RMA_TYPES(OSHMPI_INLINE_P)
+OSHMPI_RMA_TYPES(OSHMPI_INLINE_G)
+OSHMPI_AMO_TYPES(OSHMPI_INLINE_AMO)
+
+static inline long shmem_swap(long *target, long value, int pe)
+{
+    return shmem_long_swap(target, value, pe);
+}
+
+#undef OSHMPI_INLINE_P
+#undef OSHMPI_INLINE_G
+#undef OSHMPI_INLINE_AMO
+
+#endif /* OSHMPI_HAVE_INLINE */
+
+#endif /* OSHMPI_SHMEM_INLINE_H */
@@ -1,6 +1,14 @@
 /* BSD-2 License.  Written by Jeff Hammond. */
 
 #include "shmem-internals.h"
+#include "oshmpi-wait.h"
+#include "oshmpi-eager.h"
+#include "oshmpi-copy.h"
+#include "oshmpi-cma.h"
+#include "oshmpi-sheap.h"
+#include "oshmpi-sheap-cache.h"
+#include "oshmpi-topo.h"
+#include <time.h>
 
 /* this code deals with SHMEM communication out of symmetric but non-heap data */
 #if defined(HAVE_APPLE_MAC)
@@ -22,6 +30,9 @@
     /* Static causes the compiler to warn that these are unused, which is correct. */
     //static unsigned long get_etext() { return (unsigned long)&etext; }
     //static unsigned long get_edata() { return (unsigned long)&edata; }
+    /* Bounds of the SHMEMX_SYMMETRIC data, defined by the linker if there is any. */
+    extern char __start_oshmpi_symmetric[] __attribute__((weak));
+    extern char __stop_oshmpi_symmetric[]  __attribute__((weak));
 #elif defined(HAVE_AIX)
 #warning AIX is completely untested.
     /* http://pic.dhe.ibm.com/infocenter/aix/v6r1/topic/com.ibm.aix.basetechref/doc/basetrf1/_end.htm */
@@ -58,36 +69,29 @@ extern void **   shmem_smp_sheap_ptrs;
 #endif
 
 /* TODO probably want to make these 5 things into a struct typedef */
-extern MPI_Win shmem_etext_win;
-extern int     shmem_etext_size;
-extern void *  shmem_etext_base_ptr;
+extern MPI_Win  shmem_etext_win;
+extern MPI_Aint shmem_etext_size;
+extern void *   shmem_etext_base_ptr;
 
 extern MPI_Win shmem_sheap_win;
 extern long    shmem_sheap_size;
 extern void *  shmem_sheap_base_ptr;
 
 #ifdef ENABLE_MPMD_SUPPORT
-extern int     shmem_running_mpmd;
-extern int     shmem_mpmd_my_appnum;
-extern MPI_Win shmem_mpmd_appnum_win;
+extern int      shmem_running_mpmd;
+extern int      shmem_mpmd_my_appnum;
+extern MPI_Aint shmem_mpmd_appnum_disp;
 #endif
 
-/*****************************************************************/
+oshmpi_inline_state_t oshmpi_inline_state;
 
-/* Reduce overhead of MPI_Type_size in MPI-bypass Put/Get path.
- * There are other ways to solve this problem, e.g. by adding
- * an argument for the type-size to all the functions that need it. */
+static MPI_Comm oshmpi_etext_comm = MPI_COMM_NULL;
 
-static inline int OSHMPI_Type_size(MPI_Datatype mpi_type)
-{
-#ifdef MPICH
-    return (((mpi_type)&0x0000ff00)>>8);
-#else
-    int type_size;
-    MPI_Type_size(mpi_type, &type_size);
-    return type_size;
-#endif
-}
+/* Contiguous puts and gets larger than this many bytes are split into
+ * chunks with up to oshmpi_rma_chunk_depth of them in flight. */
+static size_t oshmpi_rma_chunk_size;
+static int    oshmpi_rma_chunk_depth;
+#define OSHMPI_RMA_CHUNK_DEPTH_MAX 64
 
 /*****************************************************************/
 
@@ -110,8 +114,180 @@ void oshmpi_abort(int code, char * message)
     return;
 }
 
+/* Integer-valued environment variables, with the same K/M/G suffixes
+ * as the symmetric heap size.  Returns default_value if name is unset. */
+long oshmpi_getenv_long(const char * name, long default_value)
+{
+    char * env_char = getenv(name);
+    if (env_char==NULL || env_char[0]=='\0') {
+        return default_value;
+    }
+
+    char * suffix = NULL;
+    long value = strtol(env_char, &suffix, 10);
+    if      (*suffix=='G' || *suffix=='g') value *= 1000000000L;
+    else if (*suffix=='M' || *suffix=='m') value *= 1000000L;
+    else if (*suffix=='K' || *suffix=='k') value *= 1000L;
+    return value;
+}
+
+/* The wall time of each phase of oshmpi_initialize.  With
+ * OSHMPI_INIT_PROFILE=1, PE 0 prints the maximum of each across PEs,
+ * and with 2 it prints them as a line of CSV after a header. */
+enum oshmpi_init_phase_e {
+    OSHMPI_INIT_MPI,
+    OSHMPI_INIT_COMM_DUP,
+    OSHMPI_INIT_NODE_SPLIT,
+    OSHMPI_INIT_TOPO,
+    OSHMPI_INIT_WAIT_POLICY,
+    OSHMPI_INIT_AGREEMENT,
+    OSHMPI_INIT_SHEAP,
+    OSHMPI_INIT_LOCK,
+    OSHMPI_INIT_SETUP,
+    OSHMPI_INIT_CMA,
+    OSHMPI_INIT_ETEXT,
+    OSHMPI_INIT_BARRIER,
+    OSHMPI_INIT_PHASES
+};
+
+static const char * oshmpi_init_phase_names[OSHMPI_INIT_PHASES] = {
+    "mpi_init", "comm_dup", "node_split", "topo", "wait_policy", "agreement",
+    "sheap_window", "lock", "setup", "cma", "etext_window", "barrier"
+};
+
+static double oshmpi_init_time[OSHMPI_INIT_PHASES];
+static double oshmpi_init_last;
+
+/* MPI_Wtime cannot be used before MPI_Init */
+static double oshmpi_init_clock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1.e-9*ts.tv_nsec;
+}
+
+/* charges the time since the previous mark to phase */
+static void oshmpi_init_mark(enum oshmpi_init_phase_e phase)
+{
+    double t = oshmpi_init_clock();
+    oshmpi_init_time[phase] += t - oshmpi_init_last;
+    oshmpi_init_last = t;
+}
+
+/* Collective if OSHMPI_INIT_PROFILE is set. */
+static void oshmpi_init_profile_report(int ppn)
+{
+    long mode = oshmpi_getenv_long("OSHMPI_INIT_PROFILE", 0);
+    if (mode<=0) return;
+
+    /* the last one is the total */
+    double in[OSHMPI_INIT_PHASES+1], max[OSHMPI_INIT_PHASES+1];
+    in[OSHMPI_INIT_PHASES] = 0.0;
+    for (int i=0; i<OSHMPI_INIT_PHASES; i++) {
+        in[i] = oshmpi_init_time[i];
+        in[OSHMPI_INIT_PHASES] += in[i];
+    }
+    MPI_Reduce(in, max, OSHMPI_INIT_PHASES+1, MPI_DOUBLE, MPI_MAX, 0, SHMEM_COMM_WORLD);
+
+    if (shmem_world_rank==0) {
+        if (mode==1) {
+            printf("OSHMPI initialization on %d PEs, %d per node (max over PEs, seconds)\n", shmem_world_size, ppn);
+            for (int i=0; i<OSHMPI_INIT_PHASES; i++)
+                printf("  %-14s %12.6f\n", oshmpi_init_phase_names[i], max[i]);
+            printf("  %-14s %12.6f\n", "total", max[OSHMPI_INIT_PHASES]);
+        } else {
+            printf("npes,ppn");
+            for (int i=0; i<OSHMPI_INIT_PHASES; i++)
+                printf(",%s", oshmpi_init_phase_names[i]);
+            printf(",total\n%d,%d", shmem_world_size, ppn);
+            for (int i=0; i<=OSHMPI_INIT_PHASES; i++)
+                printf(",%.6f", max[i]);
+            printf("\n");
+        }
+        fflush(stdout);
+    }
+}
+
+/* The symmetric heap size from the environment, or -1 if none is set. */
+static long oshmpi_sheap_size_env(void)
+{
+    char * env_char = NULL;
+    if (env_char==NULL) {
+        /* This is the same as OpenMPI's OpenSHMEM:
+         * http://www.mellanox.com/related-docs/prod_software/Mellanox_ScalableSHMEM_User_Manual_v2.2.pdf */
+        /* This is for Portals SHMEM (older version):
+         * http://portals-shmem.googlecode.com/svn-history/r159/trunk/src/symmetric_heap.c */
+        env_char = getenv("SHMEM_SYMMETRIC_HEAP_SIZE");
+    }
+    if (env_char==NULL) {
+        /* This is for SGI SHMEM:
+         * http://techpubs.sgi.com/library/tpl/cgi-bin/getdoc.cgi?coll=linux&db=man&fname=/usr/share/catman/man3/shmalloc.3.html */
+        /* This is for OpenSHMEM on IBM PE:
+         * http://www-01.ibm.com/support/knowledgecenter/SSFK3V_1.3.0/com.ibm.cluster.protocols.v1r3.pp300.doc/bl511_envars.htm */
+        /* This is for Portals SHMEM (older version?):
+         * https://github.com/jeffhammond/portals-shmem/blob/master/README */
+        env_char = getenv("SMA_SYMMETRIC_SIZE");
+    }
+    if (env_char==NULL) {
+        /* This is for Portals SHMEM:
+         * https://github.com/jeffhammond/portals-shmem/blob/master/src/init.c#L162 */
+        env_char = getenv("SYMMETRIC_SIZE");
+    }
+    if (env_char==NULL) {
+        /* This is for Cray SHMEM on X1:
+         * http://docs.cray.com/books/S-2179-52/html-S-2179-52/z1034699298pvl.html */
+        env_char = getenv("X1_SYMMETRIC_HEAP_SIZE");
+    }
+    if (env_char==NULL) {
+        /* This is for Cray SHMEM on XT/XE/XK/XC:
+         * http://docs.cray.com/books/S-2179-52/html-S-2179-52/z1034699298pvl.html */
+        env_char = getenv("XT_SYMMETRIC_HEAP_SIZE");
+    }
+    if (env_char==NULL) {
+        /* This is for MVAPICH2-X:
+         * http://mvapich.cse.ohio-state.edu/static/media/mvapich/mvapich2-x-2.1rc1-userguide.pdf */
+        env_char = getenv("OOSHM_SYMMETRIC_HEAP_SIZE");
+    }
+    if (env_char!=NULL) {
+        long units = 1L;
+        if      ( NULL != strstr(env_char,"G") ) units = 1000000000L;
+        else if ( NULL != strstr(env_char,"M") ) units = 1000000L;
+        else if ( NULL != strstr(env_char,"K") ) units = 1000L;
+        else                                     units = 1L;
+
+        /* atol stops at the suffix */
+        return units * atol(env_char);
+    }
+    return -1;
+}
+
+/* The symmetric heap size if none is set, from the free memory shared by
+ * the ppn PEs on this node. */
+static long oshmpi_sheap_size_default(int ppn)
+{
+#if defined(__linux__)
+    ssize_t pagesize   = sysconf(_SC_PAGESIZE);
+    ssize_t availpages = sysconf(_SC_AVPHYS_PAGES);
+    if (pagesize<0 || availpages<0) {
+        oshmpi_warn("sysconf failed\n");
+        return 128000000L;
+    } else {
+        size_t totalmem  = pagesize*availpages/ppn;
+        /* If totalmem > 2GiB, assume it is incorrect.
+         * Let user set explicitly for such cases. */
+        return (totalmem < (1L<<31)) ? totalmem : (1L<<31);
+    }
+#else
+    (void)ppn;
+    /* No joke, if one sets this to 120M to 128M, it segfaults on Mac. */
+    return 100000000L;
+#endif
+}
+
 void oshmpi_initialize(int threading)
 {
+    oshmpi_init_last = oshmpi_init_clock();
+
     {
         int flag;
         MPI_Initialized(&flag);
@@ -126,6 +302,7 @@ void oshmpi_initialize(int threading)
         if (threading<provided)
             oshmpi_abort(provided, "Your MPI implementation did not provide the requested thread support.");
     }
+    oshmpi_init_mark(OSHMPI_INIT_MPI);
 
     if (!shmem_is_initialized) {
 
@@ -133,8 +310,59 @@ void oshmpi_initialize(int threading)
         MPI_Comm_size(SHMEM_COMM_WORLD, &shmem_world_size);
         MPI_Comm_rank(SHMEM_COMM_WORLD, &shmem_world_rank);
         MPI_Comm_group(SHMEM_COMM_WORLD, &SHMEM_GROUP_WORLD);
+        oshmpi_init_mark(OSHMPI_INIT_COMM_DUP);
 
+        /* The PEs on this node, which also determine the default heap size
+         * and wait policy. */
+        int ppn;
+#ifdef ENABLE_SMP_OPTIMIZATIONS
         {
+            MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0 /* key */, MPI_INFO_NULL, &SHMEM_COMM_NODE);
+            MPI_Comm_size(SHMEM_COMM_NODE, &shmem_node_size);
+            MPI_Comm_rank(SHMEM_COMM_NODE, &shmem_node_rank);
+            MPI_Comm_group(SHMEM_COMM_NODE, &SHMEM_GROUP_NODE);
+
+            int result;
+            MPI_Comm_compare(SHMEM_COMM_WORLD, SHMEM_COMM_NODE, &result);
+            shmem_world_is_smp = (result==MPI_IDENT || result==MPI_CONGRUENT) ? 1 : 0;
+
+            shmem_smp_rank_list  = (int*) malloc( shmem_node_size*sizeof(int) );
+            int * temp_rank_list = (int*) malloc( shmem_node_size*sizeof(int) );
+            for (int i=0; i<shmem_node_size; i++) {
+                temp_rank_list[i] = i;
+            }
+            /* translate ranks in the node group to world ranks */
+            MPI_Group_translate_ranks(SHMEM_GROUP_NODE,  shmem_node_size, temp_rank_list, 
+                                      SHMEM_GROUP_WORLD, shmem_smp_rank_list);
+            free(temp_rank_list);
+        }
+        ppn = shmem_node_size;
+#else
+        {
+            MPI_Comm commtemp;
+            MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0 /* key */, MPI_INFO_NULL, &commtemp);
+            MPI_Comm_size(commtemp, &ppn);
+            MPI_Comm_free(&commtemp);
+        }
+#endif
+        oshmpi_init_mark(OSHMPI_INIT_NODE_SPLIT);
+
+        /* binds this PE, so before anything is allocated */
+        oshmpi_topo_init();
+        oshmpi_init_mark(OSHMPI_INIT_TOPO);
+        oshmpi_wait_policy_init(ppn);
+        oshmpi_init_mark(OSHMPI_INIT_WAIT_POLICY);
+
+        /* Everything the PEs have to agree on is reduced in one allreduce,
+         * with MPI_MAX and the minima negated.  What can only be known
+         * later is agreed on later: whether the heap could be mapped, and
+         * whether cross-memory attach works, which oshmpi_cma_init can
+         * only try after the node has exchanged its pids. */
+        {
+            enum { AGREE_SHEAP_SIZE, AGREE_SHEAP_DEFAULT, AGREE_APPNUM_SET, AGREE_APPNUM_MIN,
+                   AGREE_APPNUM_MAX, AGREE_WAIT_CAN_BLOCK, AGREE_COUNT };
+            long agree[AGREE_COUNT];
+
             /* Check for MPMD usage. */
             void * pappnum = NULL;
             int appnum = 0;
@@ -149,125 +377,36 @@ void oshmpi_initialize(int threading)
             if (is_set && appnum) {
                 oshmpi_abort(appnum, "You need to enable MPMD support in the build.");
             }
-#else
-            /* This may not be necessary but it is safer to check on all ranks. */
-            MPI_Allreduce(MPI_IN_PLACE, &is_set, 1, MPI_INT, MPI_MAX, SHMEM_COMM_WORLD);
-            if (is_set) {
-                shmem_mpmd_my_appnum = appnum;
-
-                /* Check for appnum homogeneity. */
-                int appmin, appmax;
-                MPI_Allreduce(&appnum, &appmin, 1, MPI_INT, MPI_MIN, SHMEM_COMM_WORLD);
-                MPI_Allreduce(&appnum, &appmax, 1, MPI_INT, MPI_MAX, SHMEM_COMM_WORLD);
-                shmem_running_mpmd = (appmin != appmax) ? 1 : 0;
-            } else {
-                shmem_running_mpmd = 0;
-            }
-
-            if (shmem_running_mpmd) {
-                /* Never going to need direct access; in any case, base is a window attribute. */
-                void * shmem_mpmd_appnum_base;
-                MPI_Win_allocate((MPI_Aint)sizeof(int), sizeof(int) /* disp_unit */, MPI_INFO_NULL, SHMEM_COMM_WORLD,
-                                 &shmem_mpmd_appnum_base, &shmem_mpmd_appnum_win);
-                MPI_Win_lock_all(0, shmem_mpmd_appnum_win);
-
-                /* Write my appnum into appropriate location in window. */
-                MPI_Accumulate(&shmem_mpmd_my_appnum, 1, MPI_INT, shmem_world_rank,
-                               (MPI_Aint)0, 1, MPI_INT, MPI_REPLACE, shmem_mpmd_appnum_win);
-                MPI_Win_flush(shmem_world_rank, shmem_mpmd_appnum_win);
-            }
 #endif
-        }
 
-        shmem_sheap_size = -1;
-        if (shmem_world_rank==0) {
-            char * env_char = NULL;
-            if (env_char==NULL) {
-                /* This is the same as OpenMPI's OpenSHMEM:
-                 * http://www.mellanox.com/related-docs/prod_software/Mellanox_ScalableSHMEM_User_Manual_v2.2.pdf */
-                /* This is for Portals SHMEM (older version):
-                 * http://portals-shmem.googlecode.com/svn-history/r159/trunk/src/symmetric_heap.c */
-                env_char = getenv("SHMEM_SYMMETRIC_HEAP_SIZE");
-            }
-            if (env_char==NULL) {
-                /* This is for SGI SHMEM:
-                 * http://techpubs.sgi.com/library/tpl/cgi-bin/getdoc.cgi?coll=linux&db=man&fname=/usr/share/catman/man3/shmalloc.3.html */
-                /* This is for OpenSHMEM on IBM PE:
-                 * http://www-01.ibm.com/support/knowledgecenter/SSFK3V_1.3.0/com.ibm.cluster.protocols.v1r3.pp300.doc/bl511_envars.htm */
-                /* This is for Portals SHMEM (older version?):
-                 * https://github.com/jeffhammond/portals-shmem/blob/master/README */
-                env_char = getenv("SMA_SYMMETRIC_SIZE");
-            }
-            if (env_char==NULL) {
-                /* This is for Portals SHMEM:
-                 * https://github.com/jeffhammond/portals-shmem/blob/master/src/init.c#L162 */
-                env_char = getenv("SYMMETRIC_SIZE");
-            }
-            if (env_char==NULL) {
-                /* This is for Cray SHMEM on X1:
-                 * http://docs.cray.com/books/S-2179-52/html-S-2179-52/z1034699298pvl.html */
-                env_char = getenv("X1_SYMMETRIC_HEAP_SIZE");
-            }
-            if (env_char==NULL) {
-                /* This is for Cray SHMEM on XT/XE/XK/XC:
-                 * http://docs.cray.com/books/S-2179-52/html-S-2179-52/z1034699298pvl.html */
-                env_char = getenv("XT_SYMMETRIC_HEAP_SIZE");
-            }
-            if (env_char==NULL) {
-                /* This is for MVAPICH2-X:
-                 * http://mvapich.cse.ohio-state.edu/static/media/mvapich/mvapich2-x-2.1rc1-userguide.pdf */
-                env_char = getenv("OOSHM_SYMMETRIC_HEAP_SIZE");
-            }
-            if (env_char!=NULL) {
-                long units = 1L;
-                if      ( NULL != strstr(env_char,"G") ) units = 1000000000L;
-                else if ( NULL != strstr(env_char,"M") ) units = 1000000L;
-                else if ( NULL != strstr(env_char,"K") ) units = 1000L;
-                else                                     units = 1L;
-
-                int num_count = strspn(env_char, "0123456789");
-                memset( &env_char[num_count], ' ', strlen(env_char)-num_count);
-                shmem_sheap_size = units * atol(env_char);
-            }
-        }
-        /* There is a way to eliminate this extra broadcast, but Jeff is lazy. */
-        MPI_Bcast( &shmem_sheap_size, 1, MPI_LONG, 0, SHMEM_COMM_WORLD );
+            agree[AGREE_SHEAP_SIZE]     = oshmpi_sheap_size_env();
+            agree[AGREE_SHEAP_DEFAULT]  = -oshmpi_sheap_size_default(ppn);
+            agree[AGREE_APPNUM_SET]     = is_set;
+            agree[AGREE_APPNUM_MIN]     = -(long)appnum;
+            agree[AGREE_APPNUM_MAX]     = appnum;
+            agree[AGREE_WAIT_CAN_BLOCK] = oshmpi_wait_can_block;
+            MPI_Allreduce(MPI_IN_PLACE, agree, AGREE_COUNT, MPI_LONG, MPI_MAX, SHMEM_COMM_WORLD);
 
-        if (shmem_sheap_size == -1) {
-#if defined(__linux__)
-            int ppn;
-            MPI_Comm commtemp;
-            MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0 /* key */, MPI_INFO_NULL, &commtemp);
-            MPI_Comm_size(commtemp, &ppn);
-            MPI_Comm_free(&commtemp);
-            ssize_t pagesize   = sysconf(_SC_PAGESIZE);
-            ssize_t availpages = sysconf(_SC_AVPHYS_PAGES);
-            if (pagesize<0 || availpages<0) {
-                oshmpi_warn("sysconf failed\n");
-                shmem_sheap_size = 128000000L;
-            } else {
-                size_t totalmem  = pagesize*availpages/ppn;
-                /* If totalmem > 2GiB, assume it is incorrect.
-                 * Let user set explicitly for such cases. */
-                shmem_sheap_size = (totalmem < (1L<<31)) ? totalmem : (1L<<31);
-            }
-#else
-            /* No joke, if one sets this to 120M to 128M, it segfaults on Mac. */
-            shmem_sheap_size = 100000000L;
+            /* the smallest default, since it depends on the free memory of each node */
+            shmem_sheap_size = (agree[AGREE_SHEAP_SIZE]>=0) ? agree[AGREE_SHEAP_SIZE] : -agree[AGREE_SHEAP_DEFAULT];
+#ifdef ENABLE_MPMD_SUPPORT
+            shmem_mpmd_my_appnum = appnum;
+            shmem_running_mpmd   = (agree[AGREE_APPNUM_SET] && -agree[AGREE_APPNUM_MIN]!=agree[AGREE_APPNUM_MAX]) ? 1 : 0;
 #endif
-            MPI_Bcast( &shmem_sheap_size, 1, MPI_LONG, 0, SHMEM_COMM_WORLD );
+            /* a writer needs to know if anyone might block, regardless of its own policy */
+            oshmpi_wait_can_block = (int)agree[AGREE_WAIT_CAN_BLOCK];
         }
         if (shmem_world_rank==0) {
             printf("OSHMPI symmetric heap size is %ld\n",shmem_sheap_size);
         }
 
-        MPI_Info sheap_info=MPI_INFO_NULL, etext_info=MPI_INFO_NULL;
+        oshmpi_init_mark(OSHMPI_INIT_AGREEMENT);
+
+        MPI_Info sheap_info=MPI_INFO_NULL;
         MPI_Info_create(&sheap_info);
-        MPI_Info_create(&etext_info);
 
         /* We define the sheap size to be symmetric and assume it for the global static data. */
         MPI_Info_set(sheap_info, "same_size", "true");
-        MPI_Info_set(etext_info, "same_size", "true");
 
 #if 0 /* def ENABLE_RMA_ORDERING - this is not ready */
         /* ENABLE_RMA_ORDERING means "RMA operations are ordered"
@@ -275,31 +414,25 @@ void oshmpi_initialize(int threading)
         /* Given the additional synchronization overhead required,
          * there is no discernible performance benefit to this. */
         MPI_Info_set(sheap_info, "accumulate_ordering", "");
-        MPI_Info_set(etext_info, "accumulate_ordering", "");
 #endif
 
-#ifdef ENABLE_SMP_OPTIMIZATIONS
-        {
-            MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0 /* key */, MPI_INFO_NULL, &SHMEM_COMM_NODE);
-            MPI_Comm_size(SHMEM_COMM_NODE, &shmem_node_size);
-            MPI_Comm_rank(SHMEM_COMM_NODE, &shmem_node_rank);
-            MPI_Comm_group(SHMEM_COMM_NODE, &SHMEM_GROUP_NODE);
-
-            int result;
-            MPI_Comm_compare(SHMEM_COMM_WORLD, SHMEM_COMM_NODE, &result);
-            shmem_world_is_smp = (result==MPI_IDENT || result==MPI_CONGRUENT) ? 1 : 0;
-
-            shmem_smp_rank_list  = (int*) malloc( shmem_node_size*sizeof(int) );
-            int * temp_rank_list = (int*) malloc( shmem_node_size*sizeof(int) );
-            for (int i=0; i<shmem_node_size; i++) {
-                temp_rank_list[i] = i;
-            }
-            /* translate ranks in the node group to world ranks */
-            MPI_Group_translate_ranks(SHMEM_GROUP_NODE,  shmem_node_size, temp_rank_list, 
-                                      SHMEM_GROUP_WORLD, shmem_smp_rank_list);
-            free(temp_rank_list);
-        }
+        /* Part (less than 128*sizeof(size_t) bytes) of this space is used for bookkeeping,
+         * so the capacity must be at least this large.  The window has to
+         * include it, or dlmalloc would manage memory past its end. */
+        shmem_sheap_size += 128*sizeof(size_t);
 
+        void ** sheap_ptrs   = NULL;
+        int     sheap_is_smp = 0;
+#ifdef ENABLE_SMP_OPTIMIZATIONS
+        sheap_is_smp = shmem_world_is_smp;
+#endif
+        if (oshmpi_sheap_create((MPI_Aint)shmem_sheap_size, sheap_info, sheap_is_smp,
+                                &shmem_sheap_base_ptr, &shmem_sheap_win, &sheap_ptrs)) {
+#ifdef ENABLE_SMP_OPTIMIZATIONS
+            shmem_smp_sheap_ptrs = sheap_ptrs;
+#endif
+        } else
+#ifdef ENABLE_SMP_OPTIMIZATIONS
         if (shmem_world_is_smp) {
             /* There is no performance advantage associated with a contiguous layout of shared memory. */
             MPI_Info_set(sheap_info, "alloc_shared_noncontig", "true");
@@ -335,11 +468,11 @@ void oshmpi_initialize(int threading)
         }
         MPI_Win_lock_all(MPI_MODE_NOCHECK /* use 0 instead if things break */, shmem_sheap_win);
 
+        /* before anything touches it */
+        oshmpi_topo_bind_memory(shmem_sheap_base_ptr, (size_t)shmem_sheap_size);
+
         /* dlmalloc mspace constructor.
          * locked may not need to be 0 if SHMEM makes no multithreaded access... */
-	/* Part (less than 128*sizeof(size_t) bytes) of this space is used for bookkeeping, 
-	 * so the capacity must be at least this large */
-	shmem_sheap_size += 128*sizeof(size_t);
 #if SHMEM_DEBUG > 5
         printf("[%d] shmem_sheap_base_ptr=%p\n", shmem_world_rank, shmem_sheap_base_ptr);
 #endif
@@ -348,67 +481,141 @@ void oshmpi_initialize(int threading)
          * is being crappy and not allocating shared memory properly. */
         memset(shmem_sheap_base_ptr,0,shmem_sheap_size);
 #endif
-        shmem_heap_mspace = create_mspace_with_base(shmem_sheap_base_ptr, shmem_sheap_size, 0 /* locked */);
+        /* dlmalloc gets what the large-object zone leaves */
+        size_t msize = oshmpi_sheap_zone_init(shmem_sheap_base_ptr, (size_t)shmem_sheap_size);
+        shmem_heap_mspace = create_mspace_with_base(shmem_sheap_base_ptr, msize, 0 /* locked */);
+        /* Otherwise dlmalloc satisfies what does not fit with private mmaps,
+         * which are not symmetric.  Fail instead, or grow the heap. */
+        mspace_set_footprint_limit(shmem_heap_mspace, mspace_footprint(shmem_heap_mspace));
+        oshmpi_sheap_segments_init();
+        oshmpi_sheap_cache_init();
+
+        /* allocates from the symmetric heap, so must be the first to do so */
+        oshmpi_wait_init();
+
+        oshmpi_init_mark(OSHMPI_INIT_SHEAP);
+
+        /* These are in the symmetric heap rather than windows of their own. */
+        oshmpi_allock();
+#ifdef ENABLE_MPMD_SUPPORT
+        if (shmem_running_mpmd) {
+            int * appnum = shmalloc(sizeof(int)); assert(appnum!=NULL);
+            *appnum = shmem_mpmd_my_appnum;
+            shmem_mpmd_appnum_disp = (MPI_Aint)((intptr_t)appnum - (intptr_t)shmem_sheap_base_ptr);
+        }
+#endif
+
+        oshmpi_init_mark(OSHMPI_INIT_LOCK);
+
+        oshmpi_inline_state.sheap_base = shmem_sheap_base_ptr;
+        oshmpi_inline_state.sheap_size = shmem_sheap_size;
+        oshmpi_inline_state.can_block  = oshmpi_wait_can_block;
+#ifdef ENABLE_SMP_OPTIMIZATIONS
+        if (shmem_world_is_smp)
+            oshmpi_inline_state.smp_ptrs = shmem_smp_sheap_ptrs;
+#endif
+
+        oshmpi_copy_init();
+        oshmpi_eager_init();
+        oshmpi_inline_state.eager_threshold = oshmpi_eager_threshold;
+
+        {
+            long chunk_size = oshmpi_getenv_long("OSHMPI_RMA_CHUNK_SIZE", 8000000);
+            long depth      = oshmpi_getenv_long("OSHMPI_RMA_CHUNK_DEPTH", 4);
+            /* each chunk must have an int count of bytes */
+            if (chunk_size>INT32_MAX) chunk_size = INT32_MAX;
+            oshmpi_rma_chunk_size  = (chunk_size>0) ? (size_t)chunk_size : 0;
+            oshmpi_rma_chunk_depth = (depth<1) ? 1 : (depth>OSHMPI_RMA_CHUNK_DEPTH_MAX) ? OSHMPI_RMA_CHUNK_DEPTH_MAX : (int)depth;
+        }
+
+        oshmpi_init_mark(OSHMPI_INIT_SETUP);
+
+        /* OSHMPI_ETEXT_WINDOW is a comma-separated list of eager or lazy,
+         * and section. */
+        int etext_section = 0;
+        {
+            char * env_char = getenv("OSHMPI_ETEXT_WINDOW");
+            char * words = (env_char!=NULL) ? strdup(env_char) : NULL;
+            char * save = NULL;
+            for (char * w = (words!=NULL) ? strtok_r(words, ",", &save) : NULL; w!=NULL; w = strtok_r(NULL, ",", &save)) {
+                if (0==strcmp(w, "lazy")) {
+                    oshmpi_etext_lazy = 1;
+                } else if (0==strcmp(w, "section")) {
+                    etext_section = 1;
+                } else if (0!=strcmp(w, "eager")) {
+                    oshmpi_warn("OSHMPI_ETEXT_WINDOW is not a list of eager or lazy, and section - ignoring the rest");
+                }
+            }
+            free(words);
+        }
 
 	shmem_etext_base_ptr = (void*) get_etext();
-        unsigned long long_etext_size   = get_end() - (unsigned long)shmem_etext_base_ptr;
-        assert(long_etext_size<(unsigned long)INT32_MAX);
-        shmem_etext_size = (int)long_etext_size;
+        shmem_etext_size     = (MPI_Aint)(get_end() - (unsigned long)shmem_etext_base_ptr);
+        if (etext_section) {
+            /* Only SHMEMX_SYMMETRIC data, rather than all of data and bss. */
+#if defined(HAVE_LINUX)
+            shmem_etext_base_ptr = __start_oshmpi_symmetric;
+            shmem_etext_size     = (MPI_Aint)(__stop_oshmpi_symmetric - __start_oshmpi_symmetric);
+#else
+            shmem_etext_base_ptr = NULL;
+            shmem_etext_size     = 0;
+#endif
+            if (shmem_etext_base_ptr==NULL) {
+                oshmpi_warn("OSHMPI_ETEXT_WINDOW=section but there is no SHMEMX_SYMMETRIC data");
+                shmem_etext_size = 0;
+            }
+        }
 
 #if defined(HAVE_APPLE_MAC) && SHMEM_DEBUG > 5
         printf("[%d] get_etext()       = %p \n", shmem_world_rank, (void*)get_etext() );
         printf("[%d] get_edata()       = %p \n", shmem_world_rank, (void*)get_edata() );
         printf("[%d] get_end()         = %p \n", shmem_world_rank, (void*)get_end()   );
         //printf("[%d] long_etext_size   = %lu \n", shmem_world_rank, long_etext_size );
-        printf("[%d] shmem_etext_size  = %d  \n", shmem_world_rank, shmem_etext_size );
+        printf("[%d] shmem_etext_size  = %ld \n", shmem_world_rank, (long)shmem_etext_size );
         //printf("[%d] my_etext_base_ptr = %p  \n", shmem_world_rank, my_etext_base_ptr );
         fflush(stdout);
 #endif
 
-#ifdef ABUSE_MPICH_FOR_GLOBALS
-        MPI_Win_create_dynamic(etext_info, SHMEM_COMM_WORLD, &shmem_etext_win);
-#else
-        MPI_Win_create(shmem_etext_base_ptr, shmem_etext_size, 1 /* disp_unit */, etext_info, SHMEM_COMM_WORLD, 
-                       &shmem_etext_win);
-#endif
-        MPI_Win_lock_all(0, shmem_etext_win);
+        /* the window's share so far is parsing OSHMPI_ETEXT_WINDOW */
+        oshmpi_init_mark(OSHMPI_INIT_ETEXT);
+
+        /* intranode puts and gets of static data bypass the window */
+        oshmpi_cma_init();
+        oshmpi_init_mark(OSHMPI_INIT_CMA);
+
+        /* Creating the window registers all of the static data, which
+         * programs that only use shmalloc do not need. */
+        if (oshmpi_etext_lazy) {
+            /* so that the creation is not ordered with the other collectives */
+            MPI_Comm_dup(SHMEM_COMM_WORLD, &oshmpi_etext_comm);
+            oshmpi_etext_request  = shmalloc(sizeof(int));
+            *oshmpi_etext_request = 0;
+            shmem_etext_win = MPI_WIN_NULL;
+        } else {
+            oshmpi_etext_create(0);
+        }
 
-        MPI_Info_free(&etext_info);
         MPI_Info_free(&sheap_info);
+        oshmpi_init_mark(OSHMPI_INIT_ETEXT);
 
         /* It is hard if not impossible to implement SHMEM without the UNIFIED model. */
         {
             int   sheap_flag = 0;
             int * sheap_model = NULL;
             MPI_Win_get_attr(shmem_sheap_win, MPI_WIN_MODEL, &sheap_model, &sheap_flag);
-            int   etext_flag = 0;
-            int * etext_model = NULL;
-            MPI_Win_get_attr(shmem_etext_win, MPI_WIN_MODEL, &etext_model, &etext_flag);
             /*
-	    if (*sheap_model != MPI_WIN_UNIFIED || *etext_model != MPI_WIN_UNIFIED) {
+	    if (*sheap_model != MPI_WIN_UNIFIED) {
                 oshmpi_abort(1, "You cannot use this implementation of SHMEM without the UNIFIED model.\n");
             }
 	    */
         }
 
-        /* allocate lock */
-	oshmpi_allock (SHMEM_COMM_WORLD);
-
-#if ENABLE_COMM_CACHING
-        shmem_comm_cache_size = 16;
-        comm_cache = malloc(shmem_comm_cache_size * sizeof(shmem_comm_t) ); assert(comm_cache!=NULL);
-        for (int i=0; i<shmem_comm_cache_size; i++) {
-            comm_cache[i].start = -1;
-            comm_cache[i].logs  = -1;
-            comm_cache[i].size  = -1;
-            comm_cache[i].comm  = MPI_COMM_NULL;
-            comm_cache[i].group = MPI_GROUP_NULL;
-        }
-#endif
-
         MPI_Barrier(SHMEM_COMM_WORLD);
 
         shmem_is_initialized = 1;
+
+        oshmpi_init_mark(OSHMPI_INIT_BARRIER);
+        oshmpi_init_profile_report(ppn);
     }
     return;
 }
@@ -421,8 +628,19 @@ void oshmpi_finalize(void)
     if (!flag) {
         if (shmem_is_initialized && !shmem_is_finalized) {
 
-       	/* clear locking window */
-	oshmpi_deallock ();
+            /* nobody is still waiting in oshmpi_etext_create */
+            if (oshmpi_etext_unsettled()) {
+                oshmpi_etext_barrier(0, 0, shmem_world_size);
+            }
+
+            oshmpi_sheap_stats_report();
+
+            oshmpi_inline_state.smp_ptrs = NULL;
+            oshmpi_inline_state.eager_threshold = 0;
+            oshmpi_eager_finalize();
+            oshmpi_wait_finalize();
+
+            oshmpi_deallock();
 #if ENABLE_COMM_CACHING
             for (int i=0; i<shmem_comm_cache_size; i++) {
                 if (comm_cache[i].comm != MPI_COMM_NULL) {
@@ -431,20 +649,27 @@ void oshmpi_finalize(void)
                 }
             }
             free(comm_cache);
+            comm_cache = NULL;
+            shmem_comm_cache_size = 0;
 #endif
             MPI_Barrier(SHMEM_COMM_WORLD);
 
-#ifdef ENABLE_MPMD_SUPPORT
-            if (shmem_running_mpmd) {
-                MPI_Win_unlock_all(shmem_mpmd_appnum_win);
-                MPI_Win_free(&shmem_mpmd_appnum_win);
+            oshmpi_sheap_segments_finalize();
+            oshmpi_sheap_zone_finalize();
+            oshmpi_cma_finalize();
+
+            if (shmem_etext_win!=MPI_WIN_NULL) {
+                MPI_Win_unlock_all(shmem_etext_win);
+                MPI_Win_free(&shmem_etext_win);
+            }
+            if (oshmpi_etext_comm!=MPI_COMM_NULL) {
+                MPI_Comm_free(&oshmpi_etext_comm);
             }
-#endif
-            MPI_Win_unlock_all(shmem_etext_win);
-            MPI_Win_free(&shmem_etext_win);
 
             MPI_Win_unlock_all(shmem_sheap_win);
             MPI_Win_free(&shmem_sheap_win);
+            oshmpi_sheap_destroy();
+            oshmpi_topo_finalize();
 
 #ifdef ENABLE_SMP_OPTIMIZATIONS
             if (shmem_world_is_smp)
@@ -475,13 +700,20 @@ void oshmpi_finalize(void)
 void oshmpi_remote_sync(void)
 {
     MPI_Win_flush_all(shmem_sheap_win);
-    MPI_Win_flush_all(shmem_etext_win);
+    if (shmem_etext_win!=MPI_WIN_NULL)
+        MPI_Win_flush_all(shmem_etext_win);
+    for (int i=0; i<oshmpi_num_segments; i++)
+        MPI_Win_flush_all(oshmpi_segments[i].win);
+    oshmpi_eager_reap();
 }
 
 void oshmpi_remote_sync_pe(int pe)
 {
     MPI_Win_flush(pe, shmem_sheap_win);
-    MPI_Win_flush(pe, shmem_etext_win);
+    if (shmem_etext_win!=MPI_WIN_NULL)
+        MPI_Win_flush(pe, shmem_etext_win);
+    for (int i=0; i<oshmpi_num_segments; i++)
+        MPI_Win_flush(pe, oshmpi_segments[i].win);
 }
 
 void oshmpi_local_sync(void)
@@ -490,7 +722,84 @@ void oshmpi_local_sync(void)
     __sync_synchronize();
 #endif
     MPI_Win_sync(shmem_sheap_win);
-    MPI_Win_sync(shmem_etext_win);
+    if (shmem_etext_win!=MPI_WIN_NULL)
+        MPI_Win_sync(shmem_etext_win);
+    for (int i=0; i<oshmpi_num_segments; i++)
+        MPI_Win_sync(oshmpi_segments[i].win);
+}
+
+void oshmpi_etext_create(int notify)
+{
+    static volatile int creating = 0;
+    if (__sync_lock_test_and_set(&creating, 1)) {
+        /* another thread of this PE got here first */
+        while (oshmpi_etext_pending())
+            OSHMPI_CPU_RELAX();
+        return;
+    }
+
+    MPI_Comm comm = SHMEM_COMM_WORLD;
+    if (oshmpi_etext_lazy) {
+        comm = oshmpi_etext_comm;
+        if (notify) {
+            int one = 1;
+            MPI_Aint disp = (MPI_Aint)((char*)oshmpi_etext_request - (char*)shmem_sheap_base_ptr);
+            for (int pe=0; pe<shmem_world_size; pe++)
+                MPI_Accumulate(&one, 1, MPI_INT, pe, disp, 1, MPI_INT, MPI_REPLACE, shmem_sheap_win);
+            MPI_Win_flush_all(shmem_sheap_win);
+#ifdef ENABLE_SMP_OPTIMIZATIONS
+            /* PEs blocked in a wait would otherwise only see it at their next timeout */
+            if (shmem_world_is_smp) {
+                for (int pe=0; pe<shmem_world_size; pe++)
+                    oshmpi_wait_wake(pe);
+            }
+#endif
+        }
+    }
+
+    MPI_Info etext_info;
+    MPI_Info_create(&etext_info);
+    MPI_Info_set(etext_info, "same_size", "true");
+
+    MPI_Win win;
+#ifdef ABUSE_MPICH_FOR_GLOBALS
+    MPI_Win_create_dynamic(etext_info, comm, &win);
+#else
+    MPI_Win_create(shmem_etext_base_ptr, shmem_etext_size, 1 /* disp_unit */, etext_info, comm, &win);
+#endif
+    MPI_Win_lock_all(0, win);
+    MPI_Info_free(&etext_info);
+
+    /* the window is usable before other threads see it */
+    __sync_synchronize();
+    shmem_etext_win = win;
+}
+
+void oshmpi_etext_barrier(int pe_start, int pe_logs, int pe_size)
+{
+    /* Dissemination, with one tag per round, which also computes whether
+     * every PE had the window when it arrived. */
+    int had = !oshmpi_etext_pending();
+    int me  = (shmem_world_rank - pe_start) >> pe_logs;
+    for (int round=0, dist=1; dist<pe_size; round++, dist*=2) {
+        int to   = pe_start + (((me+dist)%pe_size) << pe_logs);
+        int from = pe_start + (((me-dist+pe_size)%pe_size) << pe_logs);
+        int theirs = 0;
+        MPI_Request req[2];
+        MPI_Irecv(&theirs, 1, MPI_INT, from, round, oshmpi_etext_comm, &req[0]);
+        MPI_Isend(&had,    1, MPI_INT, to,   round, oshmpi_etext_comm, &req[1]);
+        int done = 0;
+        while (1) {
+            MPI_Testall(2, req, &done, MPI_STATUSES_IGNORE);
+            if (done) break;
+            oshmpi_etext_poll();
+        }
+        had = had && theirs;
+    }
+    /* the same answer on every PE */
+    if (had && pe_size==shmem_world_size) {
+        oshmpi_etext_settled = 1;
+    }
 }
 
 /* return 0 on successful lookup, otherwise 1 */
@@ -511,6 +820,7 @@ int oshmpi_window_offset(const void *address, const int pe, /* IN  */
 
     ptrdiff_t sheap_offset = (intptr_t)address - (intptr_t)shmem_sheap_base_ptr;
     ptrdiff_t etext_offset = (intptr_t)address - (intptr_t)shmem_etext_base_ptr;
+    int i;
 
     if (0 <= sheap_offset && sheap_offset <= shmem_sheap_size) {
         *win_offset = sheap_offset;
@@ -524,12 +834,19 @@ int oshmpi_window_offset(const void *address, const int pe, /* IN  */
     else if (0 <= etext_offset && etext_offset <= shmem_etext_size) {
         *win_offset = etext_offset;
         *win_id     = SHMEM_ETEXT_WINDOW;
+        if (oshmpi_etext_pending()) {
+            oshmpi_etext_create(1);
+        }
 #if SHMEM_DEBUG>5
         printf("[%d] found address in etext window \n", shmem_world_rank);
         printf("[%d] win_offset=%ld \n", shmem_world_rank, *win_offset);
 #endif
         return 0;
     }
+    else if ( unlikely(oshmpi_num_segments>0) && (i = oshmpi_segment_find(address, win_offset))>=0 ) {
+        *win_id     = SHMEM_SEGMENT_WINDOW + i;
+        return 0;
+    }
     else {
         *win_offset  = (shmem_offset_t)NULL;
         *win_id      = SHMEM_INVALID_WINDOW;
@@ -540,6 +857,61 @@ int oshmpi_window_offset(const void *address, const int pe, /* IN  */
     }
 }
 
+/* Returns 1 if the transfer is large enough to be chunked, in which case it
+ * has been done and is locally complete, and 0 otherwise. */
+static int oshmpi_rma_chunked(int is_put, MPI_Datatype mpi_type, void *origin, size_t len,
+                              int pe, MPI_Aint disp, MPI_Win win, int atomic)
+{
+    /* No type is larger than 16 bytes, so MPI_Type_size is only called for
+     * transfers that are large anyway. */
+    if ( likely(oshmpi_rma_chunk_size==0 || len<=oshmpi_rma_chunk_size/16) ) {
+        return 0;
+    }
+
+    int type_size;
+    MPI_Type_size(mpi_type, &type_size);
+    if (len*type_size<=oshmpi_rma_chunk_size) {
+        return 0;
+    }
+
+    size_t chunk = oshmpi_rma_chunk_size/type_size;
+    if (chunk<1) chunk = 1;
+
+    MPI_Request reqs[OSHMPI_RMA_CHUNK_DEPTH_MAX];
+    const int depth = oshmpi_rma_chunk_depth;
+    for (int i=0; i<depth; i++)
+        reqs[i] = MPI_REQUEST_NULL;
+
+    size_t i = 0;
+    for (size_t off=0; off<len; off+=chunk, i++) {
+        int        count = (int)((len-off<chunk) ? len-off : chunk);
+        char *     buf   = (char*)origin + off*type_size;
+        MPI_Aint   tdisp = disp + (MPI_Aint)(off*type_size);
+        MPI_Request * r  = &reqs[i%depth];
+
+        /* keep at most depth chunks in flight */
+        if (*r!=MPI_REQUEST_NULL) {
+            MPI_Wait(r, MPI_STATUS_IGNORE);
+        }
+        if (is_put) {
+            if (atomic) {
+                MPI_Raccumulate(buf, count, mpi_type, pe, tdisp, count, mpi_type, MPI_REPLACE, win, r);
+            } else {
+                MPI_Rput(buf, count, mpi_type, pe, tdisp, count, mpi_type, win, r);
+            }
+        } else {
+            if (atomic) {
+                MPI_Rget_accumulate(NULL, 0, MPI_DATATYPE_NULL, buf, count, mpi_type,
+                                    pe, tdisp, count, mpi_type, MPI_NO_OP, win, r);
+            } else {
+                MPI_Rget(buf, count, mpi_type, pe, tdisp, count, mpi_type, win, r);
+            }
+        }
+    }
+    MPI_Waitall(depth, reqs, MPI_STATUSES_IGNORE);
+    return 1;
+}
+
 void oshmpi_put(MPI_Datatype mpi_type, void *target, const void *source, size_t len, int pe)
 {
     enum shmem_window_id_e win_id;
@@ -551,6 +923,12 @@ void oshmpi_put(MPI_Datatype mpi_type, void *target, const void *source, size_t
     fflush(stdout);
 #endif
 
+    if ( unlikely(oshmpi_cma_offset(target, pe, &win_offset)) ) {
+        int type_size;
+        MPI_Type_size(mpi_type, &type_size);
+        if (0==oshmpi_cma_put(win_offset, source, len*type_size, pe)) return;
+    }
+
     if (oshmpi_window_offset(target, pe, &win_id, &win_offset)) {
         oshmpi_abort(pe, "oshmpi_window_offset failed to find put target");
     }
@@ -561,42 +939,37 @@ void oshmpi_put(MPI_Datatype mpi_type, void *target, const void *source, size_t
     fflush(stdout);
 #endif
 
-    MPI_Win win = (win_id==SHMEM_SHEAP_WINDOW) ? shmem_sheap_win : shmem_etext_win;
+    MPI_Win win    = oshmpi_win(win_id);
+    int     atomic = oshmpi_win_atomic_rma(win_id);
 
-#ifdef ENABLE_SMP_OPTIMIZATIONS
-    if (shmem_world_is_smp && win_id==SHMEM_SHEAP_WINDOW) {
-        int type_size = OSHMPI_Type_size(mpi_type);
-        void * ptr = (void*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)target - (intptr_t)shmem_sheap_base_ptr) );
-        memcpy(ptr, source, len*type_size);
-    } else
-#endif
-    {
-        int count = 0;
-        MPI_Datatype tmp_type;
-        if ( likely(len<(size_t)INT32_MAX) ) { /* need second check if size_t is signed */
-            count = len;
-            tmp_type = mpi_type;
-        } else {
-            count = 1;
-            MPIX_Type_contiguous_x(len, mpi_type, &tmp_type);
-            MPI_Type_commit(&tmp_type);
-        }
-#ifdef ENABLE_RMA_ORDERING
-        /* ENABLE_RMA_ORDERING means "RMA operations are ordered" */
+    if ( unlikely(oshmpi_rma_chunked(1, mpi_type, (void*)source, len, pe, (MPI_Aint)win_offset, win, atomic)) ) {
+        return;
+    }
+
+    int count = 0;
+    MPI_Datatype tmp_type;
+    if ( likely(len<(size_t)INT32_MAX) ) { /* need second check if size_t is signed */
+        count = len;
+        tmp_type = mpi_type;
+    } else {
+        count = 1;
+        MPIX_Type_contiguous_x(len, mpi_type, &tmp_type);
+        MPI_Type_commit(&tmp_type);
+    }
+    if (atomic) {
         MPI_Accumulate(source, count, tmp_type,                   /* origin */
                        pe, (MPI_Aint)win_offset, count, tmp_type, /* target */
                        MPI_REPLACE,                               /* atomic, ordered Put */
                        win);
-#else
+    } else {
         MPI_Put(source, count, tmp_type,                   /* origin */
                 pe, (MPI_Aint)win_offset, count, tmp_type, /* target */
                 win);
-#endif
-        if ( unlikely(len>(size_t)INT32_MAX) ) {
-            MPI_Type_free(&tmp_type);
-        }
-        MPI_Win_flush_local(pe, win);
     }
+    if ( unlikely(len>(size_t)INT32_MAX) ) {
+        MPI_Type_free(&tmp_type);
+    }
+    MPI_Win_flush_local(pe, win);
     return;
 }
 
@@ -611,6 +984,12 @@ void oshmpi_get(MPI_Datatype mpi_type, void *target, const void *source, size_t
     fflush(stdout);
 #endif
 
+    if ( unlikely(oshmpi_cma_offset(source, pe, &win_offset)) ) {
+        int type_size;
+        MPI_Type_size(mpi_type, &type_size);
+        if (0==oshmpi_cma_get(target, win_offset, len*type_size, pe)) return;
+    }
+
     if (oshmpi_window_offset(source, pe, &win_id, &win_offset)) {
         oshmpi_abort(pe, "oshmpi_window_offset failed to find get source");
     }
@@ -621,42 +1000,38 @@ void oshmpi_get(MPI_Datatype mpi_type, void *target, const void *source, size_t
     fflush(stdout);
 #endif
 
-    MPI_Win win = (win_id==SHMEM_SHEAP_WINDOW) ? shmem_sheap_win : shmem_etext_win;
-#ifdef ENABLE_SMP_OPTIMIZATIONS
-    if (shmem_world_is_smp && win_id==SHMEM_SHEAP_WINDOW) {
-        int type_size = OSHMPI_Type_size(mpi_type);
-        void * ptr = (void*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)source - (intptr_t)shmem_sheap_base_ptr) );
-        memcpy(target, ptr, len*type_size);
-    } else 
-#endif
-    {
-        int count = 0;
-        MPI_Datatype tmp_type;
-        if ( likely(len<(size_t)INT32_MAX) ) { /* need second check if size_t is signed */
-            count = len;
-            tmp_type = mpi_type;
-        } else {
-            count = 1;
-            MPIX_Type_contiguous_x(len, mpi_type, &tmp_type);
-            MPI_Type_commit(&tmp_type);
-        }
-#ifdef ENABLE_RMA_ORDERING
-        /* ENABLE_RMA_ORDERING means "RMA operations are ordered" */
+    MPI_Win win    = oshmpi_win(win_id);
+    int     atomic = oshmpi_win_atomic_rma(win_id);
+
+    if ( unlikely(oshmpi_rma_chunked(0, mpi_type, target, len, pe, (MPI_Aint)win_offset, win, atomic)) ) {
+        return;
+    }
+
+    int count = 0;
+    MPI_Datatype tmp_type;
+    if ( likely(len<(size_t)INT32_MAX) ) { /* need second check if size_t is signed */
+        count = len;
+        tmp_type = mpi_type;
+    } else {
+        count = 1;
+        MPIX_Type_contiguous_x(len, mpi_type, &tmp_type);
+        MPI_Type_commit(&tmp_type);
+    }
+    if (atomic) {
         MPI_Get_accumulate(NULL, 0, MPI_DATATYPE_NULL,                /* origin */
                            target, count, tmp_type,                   /* result */
                            pe, (MPI_Aint)win_offset, count, tmp_type, /* remote */
                            MPI_NO_OP,                                 /* atomic, ordered Get */
                            win);
-#else
+    } else {
         MPI_Get(target, count, tmp_type,                   /* result */
                 pe, (MPI_Aint)win_offset, count, tmp_type, /* remote */
                 win);
-#endif
-        if ( unlikely(len>(size_t)INT32_MAX) ) {
-            MPI_Type_free(&tmp_type);
-        }
-        MPI_Win_flush_local(pe, win);
     }
+    if ( unlikely(len>(size_t)INT32_MAX) ) {
+        MPI_Type_free(&tmp_type);
+    }
+    MPI_Win_flush_local(pe, win);
     return;
 }
 
@@ -689,7 +1064,7 @@ void oshmpi_put_strided(MPI_Datatype mpi_type, void *target, const void *source,
     fflush(stdout);
 #endif
 
-    MPI_Win win = (win_id==SHMEM_SHEAP_WINDOW) ? shmem_sheap_win : shmem_etext_win;
+    MPI_Win win = oshmpi_win(win_id);
 #ifdef ENABLE_SMP_OPTIMIZATIONS
     if (0) {
         /* TODO */
@@ -714,17 +1089,16 @@ void oshmpi_put_strided(MPI_Datatype mpi_type, void *target, const void *source,
             target_type = source_type;
         }
 
-#ifdef ENABLE_RMA_ORDERING
-        /* ENABLE_RMA_ORDERING means "RMA operations are ordered" */
-        MPI_Accumulate(source, 1, source_type,                   /* origin */
-                       pe, (MPI_Aint)win_offset, 1, target_type, /* target */
-                       MPI_REPLACE,                              /* atomic, ordered Put */
-                       win);
-#else
-        MPI_Put(source, 1, source_type,                   /* origin */
-                pe, (MPI_Aint)win_offset, 1, target_type, /* target */
-                win);
-#endif
+        if (oshmpi_win_atomic_rma(win_id)) {
+            MPI_Accumulate(source, 1, source_type,                   /* origin */
+                           pe, (MPI_Aint)win_offset, 1, target_type, /* target */
+                           MPI_REPLACE,                              /* atomic, ordered Put */
+                           win);
+        } else {
+            MPI_Put(source, 1, source_type,                   /* origin */
+                    pe, (MPI_Aint)win_offset, 1, target_type, /* target */
+                    win);
+        }
         MPI_Win_flush_local(pe, win);
 
         if (target_stride!=source_stride) {
@@ -765,7 +1139,7 @@ void oshmpi_get_strided(MPI_Datatype mpi_type, void *target, const void *source,
     fflush(stdout);
 #endif
 
-    MPI_Win win = (win_id==SHMEM_SHEAP_WINDOW) ? shmem_sheap_win : shmem_etext_win;
+    MPI_Win win = oshmpi_win(win_id);
 #ifdef ENABLE_SMP_OPTIMIZATIONS
     if (0) {
         /* TODO */
@@ -790,18 +1164,17 @@ void oshmpi_get_strided(MPI_Datatype mpi_type, void *target, const void *source,
             target_type = source_type;
         }
 
-#ifdef ENABLE_RMA_ORDERING
-        /* ENABLE_RMA_ORDERING means "RMA operations are ordered" */
-        MPI_Get_accumulate(NULL, 0, MPI_DATATYPE_NULL,                   /* origin */
-                           target, 1, target_type,                   /* result */
-                           pe, (MPI_Aint)win_offset, 1, source_type, /* remote */
-                           MPI_NO_OP,                                    /* atomic, ordered Get */
-                           win);
-#else
-        MPI_Get(target, 1, target_type,                   /* result */
-                pe, (MPI_Aint)win_offset, 1, source_type, /* remote */
-                win);
-#endif
+        if (oshmpi_win_atomic_rma(win_id)) {
+            MPI_Get_accumulate(NULL, 0, MPI_DATATYPE_NULL,                   /* origin */
+                               target, 1, target_type,                   /* result */
+                               pe, (MPI_Aint)win_offset, 1, source_type, /* remote */
+                               MPI_NO_OP,                                    /* atomic, ordered Get */
+                               win);
+        } else {
+            MPI_Get(target, 1, target_type,                   /* result */
+                    pe, (MPI_Aint)win_offset, 1, source_type, /* remote */
+                    win);
+        }
         MPI_Win_flush_local(pe, win);
 
         if (target_stride!=source_stride) 
@@ -812,6 +1185,82 @@ void oshmpi_get_strided(MPI_Datatype mpi_type, void *target, const void *source,
     return;
 }
 
+#ifdef ENABLE_SMP_OPTIMIZATIONS
+static inline void oshmpi_smp_notify(MPI_Datatype flag_type, void *ptr, const void *flag_value, MPI_Op flag_op)
+{
+    if (flag_type==MPI_LONG) {
+        if (flag_op==MPI_SUM) {
+            __sync_fetch_and_add((long*)ptr,*(long*)flag_value);
+        } else if (flag_op==MPI_REPLACE) {
+            __sync_lock_test_and_set((long*)ptr,*(long*)flag_value);
+        } else {
+            oshmpi_abort(0, "oshmpi_put_notify: invalid flag operation");
+        }
+    } else if (flag_type==MPI_UINT64_T) {
+        if (flag_op==MPI_SUM) {
+            __sync_fetch_and_add((uint64_t*)ptr,*(uint64_t*)flag_value);
+        } else if (flag_op==MPI_REPLACE) {
+            __sync_lock_test_and_set((uint64_t*)ptr,*(uint64_t*)flag_value);
+        } else {
+            oshmpi_abort(0, "oshmpi_put_notify: invalid flag operation");
+        }
+    } else {
+        oshmpi_abort(0, "oshmpi_put_notify: invalid flag type");
+    }
+}
+#endif
+
+/* MPI does not order a put before an accumulate, and orders accumulates
+ * only to the same location (not at all with accumulate_ordering=none), so
+ * off-node the payload is completed at the target by a flush before the
+ * flag is updated.  The payload is a plain put, chunked like any other. */
+void oshmpi_put_notify(void *target, const void *source, size_t len,
+                       MPI_Datatype flag_type, void *flag, const void *flag_value, MPI_Op flag_op, int pe)
+{
+    enum shmem_window_id_e win_id, flag_win_id;
+    shmem_offset_t win_offset, flag_win_offset;
+
+#if SHMEM_DEBUG>3
+    printf("[%d] oshmpi_put_notify: target=%p, source=%p, len=%zu, flag=%p, pe=%d \n",
+            shmem_world_rank, target, source, len, flag, pe);
+    fflush(stdout);
+#endif
+
+    if (oshmpi_window_offset(target, pe, &win_id, &win_offset)) {
+        oshmpi_abort(pe, "oshmpi_window_offset failed to find put target");
+    }
+    if (oshmpi_window_offset(flag, pe, &flag_win_id, &flag_win_offset)) {
+        oshmpi_abort(pe, "oshmpi_window_offset failed to find notify flag");
+    }
+
+#ifdef ENABLE_SMP_OPTIMIZATIONS
+    if (shmem_world_is_smp && win_id!=SHMEM_ETEXT_WINDOW && flag_win_id!=SHMEM_ETEXT_WINDOW) {
+        void * ptr  = oshmpi_smp_ptr(target, pe);
+        void * fptr = oshmpi_smp_ptr(flag, pe);
+        oshmpi_copy(ptr, source, len);
+        /* release the payload before the flag becomes visible */
+        __sync_synchronize();
+        oshmpi_smp_notify(flag_type, fptr, flag_value, flag_op);
+        oshmpi_wait_wake(pe);
+        return;
+    }
+#endif
+
+    oshmpi_put(MPI_BYTE, target, source, len, pe);
+    MPI_Win_flush(pe, oshmpi_win(win_id));
+
+    MPI_Win flag_win = oshmpi_win(flag_win_id);
+    MPI_Accumulate(flag_value, 1, flag_type, pe, (MPI_Aint)flag_win_offset, 1, flag_type, flag_op, flag_win);
+    MPI_Win_flush_local(pe, flag_win);
+    return;
+}
+
+/* the out-of-line half of the load-store paths in shmem-inline.h */
+void oshmpi_inline_wake(int pe)
+{
+    oshmpi_wait_wake(pe);
+}
+
 void oshmpi_swap(MPI_Datatype mpi_type, void *output, void *remote, const void *input, int pe)
 {
     enum shmem_window_id_e win_id;
@@ -821,31 +1270,10 @@ void oshmpi_swap(MPI_Datatype mpi_type, void *output, void *remote, const void *
         oshmpi_abort(pe, "oshmpi_window_offset failed to find swap remote");
     }
 
-    MPI_Win win = (win_id==SHMEM_SHEAP_WINDOW) ? shmem_sheap_win : shmem_etext_win;
+    MPI_Win win = oshmpi_win(win_id);
 
-#ifdef ENABLE_SMP_OPTIMIZATIONS
-    if (shmem_world_is_smp && win_id==SHMEM_SHEAP_WINDOW &&
-            (mpi_type==MPI_LONG || mpi_type==MPI_INT || mpi_type==MPI_LONG_LONG) ) {
-        if (mpi_type==MPI_LONG) {
-            long * ptr = (long*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)remote - (intptr_t)shmem_sheap_base_ptr) );
-            long tmp = __sync_lock_test_and_set(ptr,*(long*)input);
-            *(long*)output = tmp;
-        } else if (mpi_type==MPI_INT) {
-            int * ptr = (int*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)remote - (intptr_t)shmem_sheap_base_ptr) );
-            int tmp = __sync_lock_test_and_set(ptr,*(int*)input);
-            *(int*)output = tmp;
-        } else if (mpi_type==MPI_LONG_LONG) {
-            long long * ptr = (long long*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)remote - (intptr_t)shmem_sheap_base_ptr) );
-            long long tmp = __sync_lock_test_and_set(ptr,*(long long*)input);
-            *(long long*)output = tmp;
-        }
-        /* GCC intrinsics give the wrong answer for double swap so we just avoid trying. */
-    } else
-#endif
-    {
-        MPI_Fetch_and_op(input, output, mpi_type, pe, win_offset, MPI_REPLACE, win);
-        MPI_Win_flush(pe, win);
-    }
+    MPI_Fetch_and_op(input, output, mpi_type, pe, win_offset, MPI_REPLACE, win);
+    MPI_Win_flush(pe, win);
     return;
 }
 
@@ -858,31 +1286,10 @@ void oshmpi_cswap(MPI_Datatype mpi_type, void *output, void *remote, const void
         oshmpi_abort(pe, "oshmpi_window_offset failed to find cswap remote");
     }
 
-    MPI_Win win = (win_id==SHMEM_SHEAP_WINDOW) ? shmem_sheap_win : shmem_etext_win;
+    MPI_Win win = oshmpi_win(win_id);
 
-#ifdef ENABLE_SMP_OPTIMIZATIONS
-    if (shmem_world_is_smp && win_id==SHMEM_SHEAP_WINDOW) {
-        if (mpi_type==MPI_LONG) {
-            long * ptr = (long*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)remote - (intptr_t)shmem_sheap_base_ptr) );
-            long tmp = __sync_val_compare_and_swap(ptr,*(long*)compare,*(long*)input);
-            *(long*)output = tmp;
-        } else if (mpi_type==MPI_INT) {
-            int * ptr = (int*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)remote - (intptr_t)shmem_sheap_base_ptr) );
-            int tmp = __sync_val_compare_and_swap(ptr,*(int*)compare,*(int*)input);
-            *(int*)output = tmp;
-        } else if (mpi_type==MPI_LONG_LONG) {
-            long long * ptr = (long long*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)remote - (intptr_t)shmem_sheap_base_ptr) );
-            long long tmp = __sync_val_compare_and_swap(ptr,*(long long*)compare,*(long long*)input);
-            *(long long*)output = tmp;
-        } else {
-            oshmpi_abort(pe, "oshmpi_cswap: invalid datatype");
-        }
-    } else
-#endif
-    {
-        MPI_Compare_and_swap(input, compare, output, mpi_type, pe, win_offset, win);
-        MPI_Win_flush(pe, win);
-    }
+    MPI_Compare_and_swap(input, compare, output, mpi_type, pe, win_offset, win);
+    MPI_Win_flush(pe, win);
     return;
 }
 
@@ -895,28 +1302,10 @@ void oshmpi_add(MPI_Datatype mpi_type, void *remote, const void *input, int pe)
         oshmpi_abort(pe, "oshmpi_window_offset failed to find add remote");
     }
 
-    MPI_Win win = (win_id==SHMEM_SHEAP_WINDOW) ? shmem_sheap_win : shmem_etext_win;
+    MPI_Win win = oshmpi_win(win_id);
 
-#ifdef ENABLE_SMP_OPTIMIZATIONS
-    if (shmem_world_is_smp && win_id==SHMEM_SHEAP_WINDOW) {
-        if (mpi_type==MPI_LONG) {
-            long * ptr = (long*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)remote - (intptr_t)shmem_sheap_base_ptr) );
-            __sync_fetch_and_add(ptr,*(long*)input);
-        } else if (mpi_type==MPI_INT) {
-            int * ptr = (int*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)remote - (intptr_t)shmem_sheap_base_ptr) );
-            __sync_fetch_and_add(ptr,*(int*)input);
-        } else if (mpi_type==MPI_LONG_LONG) {
-            long long * ptr = (long long*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)remote - (intptr_t)shmem_sheap_base_ptr) );
-            __sync_fetch_and_add(ptr,*(long long*)input);
-        } else {
-            oshmpi_abort(pe, "oshmpi_add: invalid datatype");
-        }
-    } else
-#endif
-    {
-        MPI_Accumulate(input, 1, mpi_type, pe, win_offset, 1, mpi_type, MPI_SUM, win);
-        MPI_Win_flush_local(pe, win);
-    }
+    MPI_Accumulate(input, 1, mpi_type, pe, win_offset, 1, mpi_type, MPI_SUM, win);
+    MPI_Win_flush_local(pe, win);
     return;
 }
 
@@ -929,31 +1318,10 @@ void oshmpi_fadd(MPI_Datatype mpi_type, void *output, void *remote, const void *
         oshmpi_abort(pe, "oshmpi_window_offset failed to find fadd remote");
     }
 
-    MPI_Win win = (win_id==SHMEM_SHEAP_WINDOW) ? shmem_sheap_win : shmem_etext_win;
+    MPI_Win win = oshmpi_win(win_id);
 
-#ifdef ENABLE_SMP_OPTIMIZATIONS
-    if (shmem_world_is_smp && win_id==SHMEM_SHEAP_WINDOW) {
-        if (mpi_type==MPI_LONG) {
-            long * ptr = (long*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)remote - (intptr_t)shmem_sheap_base_ptr) );
-            long tmp = __sync_fetch_and_add(ptr,*(long*)input);
-            *(long*)output = tmp;
-        } else if (mpi_type==MPI_INT) {
-            int * ptr = (int*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)remote - (intptr_t)shmem_sheap_base_ptr) );
-            int tmp = __sync_fetch_and_add(ptr,*(int*)input);
-            *(int*)output = tmp;
-        } else if (mpi_type==MPI_LONG_LONG) {
-            long long * ptr = (long long*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + ((intptr_t)remote - (intptr_t)shmem_sheap_base_ptr) );
-            long long tmp = __sync_fetch_and_add(ptr,*(long long*)input);
-            *(long long*)output = tmp;
-        } else {
-            oshmpi_abort(pe, "oshmpi_fadd: invalid datatype");
-        }
-    } else
-#endif
-    {
-        MPI_Fetch_and_op(input, output, mpi_type, pe, win_offset, MPI_SUM, win);
-        MPI_Win_flush(pe, win);
-    }
+    MPI_Fetch_and_op(input, output, mpi_type, pe, win_offset, MPI_SUM, win);
+    MPI_Win_flush(pe, win);
     return;
 }
 
@@ -992,6 +1360,18 @@ static inline void oshmpi_acquire_comm(int pe_start, int pe_logs, int pe_size, /
     }
 
 #if ENABLE_COMM_CACHING
+    /* only programs that use subsets of PEs need it */
+    if ( unlikely(comm_cache==NULL) ) {
+        shmem_comm_cache_size = 16;
+        comm_cache = malloc(shmem_comm_cache_size * sizeof(shmem_comm_t) ); assert(comm_cache!=NULL);
+        for (int i=0; i<shmem_comm_cache_size; i++) {
+            comm_cache[i].start = -1;
+            comm_cache[i].logs  = -1;
+            comm_cache[i].size  = -1;
+            comm_cache[i].comm  = MPI_COMM_NULL;
+            comm_cache[i].group = MPI_GROUP_NULL;
+        }
+    }
     for (int i=0; i<shmem_comm_cache_size; i++)
     {
         if (pe_start == comm_cache[i].start &&
@@ -1075,6 +1455,10 @@ void oshmpi_coll(enum shmem_coll_type_e coll, MPI_Datatype mpi_type, MPI_Op redu
     int broot = 0;
     MPI_Comm comm;
 
+    if (oshmpi_etext_unsettled()) {
+        oshmpi_etext_barrier(pe_start, pe_logs, pe_size);
+    }
+
     oshmpi_acquire_comm(pe_start, pe_logs, pe_size, &comm,
                          pe_root, &broot);
 
@@ -47,9 +47,17 @@ void **   shmem_smp_sheap_ptrs;
 #endif
 
 /* TODO probably want to make these 5 things into a struct typedef */
-MPI_Win shmem_etext_win;
-int     shmem_etext_size;
-void *  shmem_etext_base_ptr;
+MPI_Win  shmem_etext_win;
+MPI_Aint shmem_etext_size;
+void *   shmem_etext_base_ptr;
+
+/* With OSHMPI_ETEXT_WINDOW=lazy, shmem_etext_win is MPI_WIN_NULL until the
+ * first PE resolves an address in the static data.  That PE raises the
+ * request flag of every PE and enters MPI_Win_create, and the others join
+ * it from the next library call that may block (see oshmpi_etext_poll). */
+int            oshmpi_etext_lazy;
+int            oshmpi_etext_settled; /* every PE knows that it exists */
+volatile int * oshmpi_etext_request; /* in the symmetric heap */
 
 MPI_Win shmem_sheap_win;
 long    shmem_sheap_size;
@@ -58,10 +66,30 @@ void *  shmem_sheap_base_ptr;
 /* dlmalloc mspace... */
 mspace shmem_heap_mspace;
 
+/* Segments added when a growable heap is exhausted (OSHMPI_SHEAP_GROWABLE).
+ * Segment i is window SHMEM_SEGMENT_WINDOW+i.  Addresses in the initial
+ * heap never look at this table. */
+#define OSHMPI_MAX_SEGMENTS 64
+typedef struct oshmpi_segment_s {
+    char *  base;
+    size_t  size;
+    MPI_Win win;
+    mspace  msp;
+    void ** smp_ptrs; /* NULL unless every PE is reachable by load-store */
+    int     flags;
+} oshmpi_segment_t;
+
+#define OSHMPI_SEGMENT_SPACE      1 /* a shmemx space, not used by shmalloc */
+#define OSHMPI_SEGMENT_ATOMIC_RMA 2 /* put and get are done with accumulate */
+#define OSHMPI_SEGMENT_HUGEPAGES  4 /* madvise(MADV_HUGEPAGE) */
+
+int              oshmpi_num_segments;
+oshmpi_segment_t oshmpi_segments[OSHMPI_MAX_SEGMENTS];
+
 #ifdef ENABLE_MPMD_SUPPORT
-int     shmem_running_mpmd;
-int     shmem_mpmd_my_appnum;
-MPI_Win shmem_mpmd_appnum_win;
+int      shmem_running_mpmd;
+int      shmem_mpmd_my_appnum;
+MPI_Aint shmem_mpmd_appnum_disp; /* in the window of the symmetric heap */
 #endif
 
 #if ENABLE_COMM_CACHING
@@ -82,7 +110,7 @@ shmem_comm_t * comm_cache;
 #endif
 /*****************************************************************/
 
-enum shmem_window_id_e { SHMEM_SHEAP_WINDOW = 0, SHMEM_ETEXT_WINDOW = 1, SHMEM_INVALID_WINDOW = -1 };
+enum shmem_window_id_e { SHMEM_SHEAP_WINDOW = 0, SHMEM_ETEXT_WINDOW = 1, SHMEM_SEGMENT_WINDOW = 2, SHMEM_INVALID_WINDOW = -1 };
 enum shmem_coll_type_e { SHMEM_BARRIER = 0, SHMEM_BROADCAST = 1, SHMEM_ALLREDUCE = 2, SHMEM_FCOLLECT = 4, SHMEM_COLLECT = 8};
 
 /*****************************************************************/
@@ -91,6 +119,8 @@ void oshmpi_warn(char * message);
 
 void oshmpi_abort(int code, char * message);
 
+long oshmpi_getenv_long(const char * name, long default_value);
+
 /* This function is not used because we do not need this information 
  * int oshmpi_address_is_symmetric(size_t my_sheap_base_ptr);
  */
@@ -109,6 +139,82 @@ void oshmpi_remote_sync_pe(int);
 int oshmpi_window_offset(const void *address, const int pe,
                          enum shmem_window_id_e * win_id, shmem_offset_t * win_offset);     
 
+static inline MPI_Win oshmpi_win(enum shmem_window_id_e win_id)
+{
+    if ( likely(win_id==SHMEM_SHEAP_WINDOW) ) return shmem_sheap_win;
+    if (win_id==SHMEM_ETEXT_WINDOW)           return shmem_etext_win;
+    return oshmpi_segments[win_id-SHMEM_SEGMENT_WINDOW].win;
+}
+
+/* Collective, but entered by one PE on first use and by the others from
+ * oshmpi_etext_poll.  notify is 0 when called for a request. */
+void oshmpi_etext_create(int notify);
+
+static inline int oshmpi_etext_pending(void)
+{
+    return unlikely(oshmpi_etext_lazy) && *(volatile MPI_Win *)&shmem_etext_win==MPI_WIN_NULL;
+}
+
+static inline void oshmpi_etext_poll(void)
+{
+    if (oshmpi_etext_pending() && *oshmpi_etext_request)
+        oshmpi_etext_create(0);
+}
+
+/* Until then, collectives must not block in MPI, so they are preceded by
+ * (or, for barriers, replaced with) oshmpi_etext_barrier, which waits with
+ * point-to-point messages and lets the PE join the creation meanwhile.  A
+ * barrier over all PEs that finds the window everywhere settles it, and
+ * then collectives are plain MPI again. */
+static inline int oshmpi_etext_unsettled(void)
+{
+    return unlikely(oshmpi_etext_lazy) && !oshmpi_etext_settled;
+}
+
+void oshmpi_etext_barrier(int pe_start, int pe_logs, int pe_size);
+
+/* Returns 1 if put and get to the window must be MPI_Accumulate and
+ * MPI_Get_accumulate, which are atomic with respect to the AMOs. */
+static inline int oshmpi_win_atomic_rma(enum shmem_window_id_e win_id)
+{
+#ifdef ENABLE_RMA_ORDERING
+    /* ENABLE_RMA_ORDERING means "RMA operations are ordered" */
+    return 1;
+#else
+    return unlikely(win_id>=SHMEM_SEGMENT_WINDOW) &&
+           (oshmpi_segments[win_id-SHMEM_SEGMENT_WINDOW].flags & OSHMPI_SEGMENT_ATOMIC_RMA);
+#endif
+}
+
+/* index of the segment containing address, or -1 (O(log n), out of line) */
+int oshmpi_segment_find(const void *address, shmem_offset_t * offset);
+
+/* Load-store address of a symmetric heap address at pe, or NULL if pe
+ * can only be reached through MPI.  The typed entry points in shmem.c try
+ * this first; the functions below always go through the windows. */
+#ifdef ENABLE_SMP_OPTIMIZATIONS
+static inline void * oshmpi_smp_ptr(const void *address, int pe)
+{
+    ptrdiff_t offset = (intptr_t)address - (intptr_t)shmem_sheap_base_ptr;
+    if (shmem_world_is_smp && 0<=offset && offset<shmem_sheap_size) {
+        return (void*)( (intptr_t)shmem_smp_sheap_ptrs[pe] + offset );
+    }
+    if ( unlikely(oshmpi_num_segments>0) ) {
+        shmem_offset_t seg_offset;
+        int i = oshmpi_segment_find(address, &seg_offset);
+        if (i>=0 && oshmpi_segments[i].smp_ptrs!=NULL)
+            return (void*)( (intptr_t)oshmpi_segments[i].smp_ptrs[pe] + seg_offset );
+    }
+    return NULL;
+}
+#else
+static inline void * oshmpi_smp_ptr(const void *address, int pe)
+{
+    (void)address; (void)pe;
+    return NULL;
+}
+#endif
+
 void oshmpi_put(MPI_Datatype mpi_type, void *target, const void *source, size_t len, int pe);
 void oshmpi_get(MPI_Datatype mpi_type, void *target, const void *source, size_t len, int pe);
 void oshmpi_put_strided(MPI_Datatype mpi_type, void *target, const void *source, 
@@ -116,6 +222,12 @@ void oshmpi_put_strided(MPI_Datatype mpi_type, void *target, const void *source,
 void oshmpi_get_strided(MPI_Datatype mpi_type, void *target, const void *source, 
                         ptrdiff_t target_ptrdiff, ptrdiff_t source_ptrdiff, size_t len, int pe);
 
+/* put of len bytes followed by an update of flag at the same pe, which is issued
+ * only after the payload is complete at the target.  Through shared memory that
+ * is a store fence; otherwise it takes an MPI_Win_flush between the two. */
+void oshmpi_put_notify(void *target, const void *source, size_t len,
+                       MPI_Datatype flag_type, void *flag, const void *flag_value, MPI_Op flag_op, int pe);
+
 void oshmpi_swap(MPI_Datatype mpi_type, void *output, void *remote, const void *input, int pe);
 void oshmpi_cswap(MPI_Datatype mpi_type, void *output, void *remote, const void *input, const void *compare, int pe);
 void oshmpi_add(MPI_Datatype mpi_type, void *remote, const void *input, int pe);
@@ -0,0 +1,52 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#ifndef OSHMPI_SHMEM_TYPES_H
+#define OSHMPI_SHMEM_TYPES_H
+
+/* The type table from which the typed RMA and AMO entry points are generated.
+ * Each list takes a macro X and applies it to every type, so that each
+ * entry point is specialized with a compile-time element size and atomic
+ * width and the MPI datatype is only consulted when MPI does the work. */
+
+/* X(name, C type, MPI datatype) for the standard RMA types */
+#define OSHMPI_RMA_TYPES(X)                      \
+    X(float,      float,       MPI_FLOAT)        \
+    X(double,     double,      MPI_DOUBLE)       \
+    X(longdouble, long double, MPI_LONG_DOUBLE)  \
+    X(char,       char,        MPI_CHAR)         \
+    X(short,      short,       MPI_SHORT)        \
+    X(int,        int,         MPI_INT)          \
+    X(long,       long,        MPI_LONG)         \
+    X(longlong,   long long,   MPI_LONG_LONG)
+
+/* X(name, C type, MPI datatype) for the contiguous-only complex types */
+#define OSHMPI_COMPLEX_TYPES(X)                      \
+    X(complexf, float complex,  MPI_COMPLEX)         \
+    X(complexd, double complex, MPI_DOUBLE_COMPLEX)
+
+/* X(bits, C type, MPI datatype) for the sized routines (put32, iget64, ...).
+ * FIXME Why MPI_DOUBLE rather than MPI_INT64_T and MPI_C_DOUBLE_COMPLEX
+ *       rather than 2*MPI_INT64_T?  I recall something we tried before
+ *       didn't work, but what was it? */
+#define OSHMPI_SIZED_TYPES(X)                        \
+    X(32,  int32_t,        MPI_INT32_T)              \
+    X(64,  int64_t,        MPI_DOUBLE)               \
+    X(128, double complex, MPI_C_DOUBLE_COMPLEX)
+
+/* X(name, C type, MPI datatype) for the integer AMOs */
+#define OSHMPI_AMO_TYPES(X)                      \
+    X(int,        int,         MPI_INT)          \
+    X(long,       long,        MPI_LONG)         \
+    X(longlong,   long long,   MPI_LONG_LONG)
+
+/* X(name, C type, MPI datatype, integer of the same width) for swap,
+ * which is also defined for floating-point.  The __sync builtins only
+ * work on integers, so the value is swapped as its bit pattern. */
+#define OSHMPI_SWAP_TYPES(X)                             \
+    X(float,      float,       MPI_FLOAT,     int32_t)   \
+    X(double,     double,      MPI_DOUBLE,    int64_t)   \
+    X(int,        int,         MPI_INT,       int)       \
+    X(long,       long,        MPI_LONG,      long)      \
+    X(longlong,   long long,   MPI_LONG_LONG, long long)
+
+#endif /* OSHMPI_SHMEM_TYPES_H */
@@ -14,6 +14,7 @@
 #define SHMEM_WAIT_H
 
 #include "shmem-internals.h"
+#include "oshmpi-wait.h"
 
 #define COMP(type, a, b, ret)                                \
     do {                                                     \
@@ -48,18 +49,18 @@
         shmem_offset_t offset;                                              \
         oshmpi_window_offset(address, shmem_world_rank, &id, &offset);      \
                                                                             \
-        MPI_Win win;                                                        \
-        if (id==SHMEM_SHEAP_WINDOW)                                         \
-            win = shmem_sheap_win;                                          \
-        else if (id==SHMEM_ETEXT_WINDOW)                                    \
-            win = shmem_etext_win;                                          \
+        MPI_Win win = oshmpi_win(id);                                       \
                                                                             \
-        temp = value;                                                       \
-        while (temp == value) {                                             \
+        oshmpi_wait_t w;                                                    \
+        oshmpi_wait_begin(&w);                                              \
+        while (1) {                                                         \
             MPI_Fetch_and_op(NULL, &temp, mpi_type, shmem_world_rank,       \
                              offset, MPI_NO_OP, win);                       \
             MPI_Win_flush_local(shmem_world_rank, win);                     \
+            if (temp != value) break;                                       \
+            oshmpi_wait_poll(&w);                                           \
         }                                                                   \
+        oshmpi_wait_end(&w);                                                \
     } while(0)
 
 
@@ -69,20 +70,100 @@
         shmem_offset_t offset; /* not used */                               \
         oshmpi_window_offset(address, shmem_world_rank, &id, &offset);      \
                                                                             \
-        MPI_Win win;                                                        \
-        if (id==SHMEM_SHEAP_WINDOW)                                         \
-            win = shmem_sheap_win;                                          \
-        else if (id==SHMEM_ETEXT_WINDOW)                                    \
-            win = shmem_etext_win;                                          \
+        MPI_Win win = oshmpi_win(id);                                       \
                                                                             \
         int cmpret=0;                                                       \
-        while (!cmpret) {                                                   \
+        oshmpi_wait_t w;                                                    \
+        oshmpi_wait_begin(&w);                                              \
+        while (1) {                                                         \
             MPI_Fetch_and_op(NULL, &temp, mpi_type, shmem_world_rank,       \
                              offset, MPI_NO_OP, win);                       \
             MPI_Win_flush_local(shmem_world_rank, win);                     \
             COMP(cond, temp, value, cmpret);                                \
+            if (cmpret) break;                                              \
+            oshmpi_wait_poll(&w);                                           \
         }                                                                   \
+        oshmpi_wait_end(&w);                                                \
     } while(0)
 
+/* The following read the (local) ivars directly rather than via MPI_Fetch_and_op
+ * so that many variables can be scanned in a single polling loop. */
+
+#define SHMEM_TEST(type, ivar, cond, value, ret)                            \
+    do {                                                                    \
+        type temp;                                                          \
+        oshmpi_local_sync();                                                \
+        temp = *(volatile type *)(ivar);                                    \
+        COMP(cond, temp, value, ret);                                       \
+    } while(0)
+
+/* ret is SIZE_MAX if every element is excluded by status */
+#define SHMEM_WAIT_UNTIL_ANY(type, ivars, nelems, status, cond, value, ret) \
+    do {                                                                    \
+        size_t ncand = 0;                                                   \
+        for (size_t i=0; i<(nelems); i++)                                   \
+            if ((status)==NULL || !(status)[i]) ncand++;                    \
+        ret = SIZE_MAX;                                                     \
+        if (ncand==0) break;                                                \
+                                                                            \
+        oshmpi_wait_t w;                                                    \
+        oshmpi_wait_begin(&w);                                              \
+        oshmpi_local_sync();                                                \
+        while (ret==SIZE_MAX) {                                             \
+            for (size_t i=0; i<(nelems); i++) {                             \
+                if ((status)!=NULL && (status)[i]) continue;                \
+                type temp = ((volatile type *)(ivars))[i];                  \
+                int cmpret;                                                 \
+                COMP(cond, temp, value, cmpret);                            \
+                if (cmpret) { ret = i; break; }                             \
+            }                                                               \
+            if (ret==SIZE_MAX) oshmpi_wait_poll(&w);                        \
+        }                                                                   \
+        oshmpi_wait_end(&w);                                                \
+    } while(0)
+
+#define SHMEM_WAIT_UNTIL_ALL(type, ivars, nelems, status, cond, value)      \
+    do {                                                                    \
+        oshmpi_wait_t w;                                                    \
+        oshmpi_wait_begin(&w);                                              \
+        oshmpi_local_sync();                                                \
+        for (size_t i=0; i<(nelems); i++) {                                 \
+            if ((status)!=NULL && (status)[i]) continue;                    \
+            int cmpret = 0;                                                 \
+            while (1) {                                                     \
+                type temp = ((volatile type *)(ivars))[i];                  \
+                COMP(cond, temp, value, cmpret);                            \
+                if (cmpret) break;                                          \
+                oshmpi_wait_poll(&w);                                       \
+            }                                                               \
+        }                                                                   \
+        oshmpi_wait_end(&w);                                                \
+    } while(0)
+
+/* ret is the number of indices written, which is 0 only if every
+ * element is excluded by status */
+#define SHMEM_WAIT_UNTIL_SOME(type, ivars, nelems, indices, status, cond, value, ret) \
+    do {                                                                    \
+        size_t ncand = 0;                                                   \
+        for (size_t i=0; i<(nelems); i++)                                   \
+            if ((status)==NULL || !(status)[i]) ncand++;                    \
+        ret = 0;                                                            \
+        if (ncand==0) break;                                                \
+                                                                            \
+        oshmpi_wait_t w;                                                    \
+        oshmpi_wait_begin(&w);                                              \
+        oshmpi_local_sync();                                                \
+        while (ret==0) {                                                    \
+            for (size_t i=0; i<(nelems); i++) {                             \
+                if ((status)!=NULL && (status)[i]) continue;                \
+                type temp = ((volatile type *)(ivars))[i];                  \
+                int cmpret;                                                 \
+                COMP(cond, temp, value, cmpret);                            \
+                if (cmpret) (indices)[ret++] = i;                           \
+            }                                                               \
+            if (ret==0) oshmpi_wait_poll(&w);                               \
+        }                                                                   \
+        oshmpi_wait_end(&w);                                                \
+    } while(0)
 
 #endif // SHMEM_WAIT_H
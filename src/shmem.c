@@ -17,6 +17,11 @@
 #include "shmem.h"
 #include "shmem-internals.h"
 #include "shmem-wait.h"
+#include "oshmpi-eager.h"
+#include "oshmpi-copy.h"
+#include "oshmpi-sheap.h"
+#include "oshmpi-sheap-cache.h"
+#include "shmem-types.h"
 #include "oshmpi-mcs-lock.h"
 #include "dlmalloc.h"
 
@@ -63,13 +68,12 @@ int shmem_pe_accessible(int pe)
     if (shmem_running_mpmd) {
         int pe_appnum;
         /* Don't need a valid PE check since these operations will fail in that case. */
-        MPI_Fetch_and_op(NULL, &pe_appnum, MPI_INT, pe, 0, MPI_NO_OP, shmem_mpmd_appnum_win);
-        MPI_Win_flush(pe, shmem_mpmd_appnum_win);
+        MPI_Fetch_and_op(NULL, &pe_appnum, MPI_INT, pe, shmem_mpmd_appnum_disp, MPI_NO_OP, shmem_sheap_win);
+        MPI_Win_flush(pe, shmem_sheap_win);
         return (shmem_mpmd_my_appnum == pe_appnum);
     }
-#else
-    return ( 0<=pe && pe<=shmem_world_size );
 #endif
+    return ( 0<=pe && pe<=shmem_world_size );
 }
 
 int shmem_addr_accessible(void *addr, int pe)
@@ -89,22 +93,88 @@ int shmem_addr_accessible(void *addr, int pe)
 
 void *shmemalign(size_t alignment, size_t size)
 {
-    return mspace_memalign(shmem_heap_mspace, alignment, size);
+    return oshmpi_sheap_cache_miss(alignment, size);
 }
 
 void *shmalloc(size_t size)
 {
-    return mspace_malloc(shmem_heap_mspace, size);
+    /* size-1 so that 0 is not cached */
+    if ( likely(size-1 < oshmpi_sheap_cache_max) ) {
+        return oshmpi_sheap_cache_malloc(size);
+    }
+    return oshmpi_sheap_cache_miss(0, size);
+}
+
+/* with the heap lock held */
+static void * oshmpi_sheap_realloc(void *ptr, size_t size)
+{
+    if ( unlikely(oshmpi_sheap_growable) && ptr!=NULL ) {
+        return oshmpi_sheap_segment_realloc(ptr, size);
+    }
+    size_t old = (ptr!=NULL) ? mspace_usable_size(ptr) : 0;
+    void * p = mspace_realloc(shmem_heap_mspace, ptr, size);
+    if (p!=NULL) {
+        oshmpi_sheap_count_free(old);
+        oshmpi_sheap_count_alloc(mspace_usable_size(p));
+    }
+    return p;
 }
 
 void *shrealloc(void *ptr, size_t size)
 {
-    return mspace_realloc(shmem_heap_mspace, ptr, size);
+    void * p;
+    if ( unlikely(oshmpi_sheap_in_zone(ptr)) ) {
+        oshmpi_sheap_lock();
+        size_t old = oshmpi_sheap_zone_usable_size(ptr);
+        oshmpi_sheap_unlock();
+        if (size<=old && size>=oshmpi_sheap_large_threshold) return ptr;
+        p = shmalloc(size);
+        if (p!=NULL) {
+            memcpy(p, ptr, (old<size) ? old : size);
+            shfree(ptr);
+        }
+        return p;
+    }
+    oshmpi_sheap_lock();
+    p = oshmpi_sheap_realloc(ptr, size);
+    /* as in oshmpi_sheap_cache_miss, the magazines may hold the room */
+    if ( unlikely(p==NULL) && size>0 && oshmpi_sheap_cache_flush()>0 ) {
+        p = oshmpi_sheap_realloc(ptr, size);
+    }
+    oshmpi_sheap_unlock();
+    return p;
 }
 
 void shfree(void *ptr)
 {
-    return mspace_free(shmem_heap_mspace, ptr);
+    if (ptr==NULL) return;
+
+    if ( unlikely(oshmpi_sheap_in_zone(ptr)) ) {
+        oshmpi_sheap_lock();
+        oshmpi_sheap_count_free(oshmpi_sheap_zone_usable_size(ptr));
+        oshmpi_sheap_zone_free(ptr);
+        oshmpi_sheap_unlock();
+        return;
+    }
+    if ( unlikely(oshmpi_num_segments>0) && !oshmpi_sheap_is_initial(ptr) ) {
+        oshmpi_sheap_lock();
+        oshmpi_sheap_segment_free(ptr);
+        oshmpi_sheap_unlock();
+        return;
+    }
+    size_t size = mspace_usable_size(ptr);
+    if ( likely(oshmpi_sheap_cache_free(ptr, size)) ) {
+        return;
+    }
+    oshmpi_sheap_lock();
+    oshmpi_sheap_count_free(size);
+    /* while the block is still ours, since dlmalloc may hand it out again
+     * as soon as it has it back */
+    if ( unlikely(size>=oshmpi_sheap_release_threshold) ) {
+        oshmpi_sheap_release(ptr, size);
+    }
+    mspace_free(shmem_heap_mspace, ptr);
+    oshmpi_sheap_unlock();
 }
 
 void shmem_quiet(void)
@@ -141,8 +211,8 @@ void *shmem_ptr(void *target, int pe)
         oshmpi_abort(pe, "oshmpi_window_offset failed to find source");
     }
 
-    if (shmem_world_is_smp && win_id==SHMEM_SHEAP_WINDOW) {
-        return (shmem_smp_sheap_ptrs[pe] + (target - shmem_sheap_base_ptr));
+    if (shmem_world_is_smp && win_id!=SHMEM_ETEXT_WINDOW) {
+        return oshmpi_smp_ptr(target, pe);
     } else
 #endif
     {
@@ -150,292 +220,152 @@ void *shmem_ptr(void *target, int pe)
     }
 }
 
-/* 8.6: Elemental Put Routines */
-void shmem_float_p(float *addr, float v, int pe)
-{
-    oshmpi_put(MPI_FLOAT, addr, &v, 1, pe);
-}
-void shmem_double_p(double *addr, double v, int pe)
-{
-    oshmpi_put(MPI_DOUBLE, addr, &v, 1, pe);
-}
-void shmem_longdouble_p(long double *addr, long double v, int pe)
-{
-    oshmpi_put(MPI_LONG_DOUBLE, addr, &v, 1, pe);
-}
-void shmem_char_p(char *addr, char v, int pe)
+/* The typed RMA and AMO entry points are generated from the type table in
+ * shmem-types.h.  The helpers are inlined into every one of them, so the
+ * element size is a compile-time constant and intranode access is a
+ * fixed-size copy or atomic.  Only the MPI path needs the datatype. */
+
+static inline void oshmpi_typed_put(MPI_Datatype mpi_type, size_t type_size,
+                                    void *target, const void *source, size_t len, int pe)
 {
-    oshmpi_put(MPI_CHAR, addr, &v, 1, pe);
+    void * ptr = oshmpi_smp_ptr(target, pe);
+    if (ptr!=NULL) {
+        oshmpi_copy(ptr, source, len*type_size);
+        oshmpi_wait_wake(pe);
+    } else if (len*type_size<=oshmpi_eager_threshold) {
+        oshmpi_put_eager(target, source, len*type_size, pe);
+    } else {
+        oshmpi_put(mpi_type, target, source, len, pe);
+    }
 }
-void shmem_short_p(short *addr, short v, int pe)
+
+static inline void oshmpi_typed_get(MPI_Datatype mpi_type, size_t type_size,
+                                    void *target, const void *source, size_t len, int pe)
 {
-    oshmpi_put(MPI_SHORT, addr, &v, 1, pe);
+    void * ptr = oshmpi_smp_ptr(source, pe);
+    if (ptr!=NULL) {
+        oshmpi_copy(target, ptr, len*type_size);
+    } else {
+        oshmpi_get(mpi_type, target, source, len, pe);
+    }
 }
-void shmem_int_p(int *addr, int v, int pe)
+
+static inline void oshmpi_typed_put_strided(MPI_Datatype mpi_type, size_t type_size,
+                                            void *target, const void *source,
+                                            ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
 {
-    oshmpi_put(MPI_INT, addr, &v, 1, pe);
+    char * ptr = oshmpi_smp_ptr(target, pe);
+    if (ptr!=NULL) {
+        const ptrdiff_t ts = (ptrdiff_t)type_size;
+        for (ptrdiff_t i=0; i<(ptrdiff_t)len; i++)
+            memcpy(ptr + i*tst*ts, (const char*)source + i*sst*ts, type_size);
+        oshmpi_wait_wake(pe);
+    } else {
+        oshmpi_put_strided(mpi_type, target, source, tst, sst, len, pe);
+    }
 }
-void shmem_long_p(long *addr, long v, int pe)
+
+static inline void oshmpi_typed_get_strided(MPI_Datatype mpi_type, size_t type_size,
+                                            void *target, const void *source,
+                                            ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
 {
-    oshmpi_put(MPI_LONG, addr, &v, 1, pe);
+    const char * ptr = oshmpi_smp_ptr(source, pe);
+    if (ptr!=NULL) {
+        const ptrdiff_t ts = (ptrdiff_t)type_size;
+        for (ptrdiff_t i=0; i<(ptrdiff_t)len; i++)
+            memcpy((char*)target + i*tst*ts, ptr + i*sst*ts, type_size);
+    } else {
+        oshmpi_get_strided(mpi_type, target, source, tst, sst, len, pe);
+    }
 }
-void shmem_longlong_p(long long *addr, long long v, int pe)
-{
-    oshmpi_put(MPI_LONG_LONG, addr, &v, 1, pe);
+
+/* 8.6: Elemental Put Routines */
+#define OSHMPI_DEFINE_P(NAME, TYPE, MPI_TYPE)                                       \
+void shmem_##NAME##_p(TYPE *addr, TYPE v, int pe)                                   \
+{                                                                                   \
+    oshmpi_typed_put(MPI_TYPE, sizeof(TYPE), addr, &v, 1, pe);                      \
 }
+OSHMPI_RMA_TYPES(OSHMPI_DEFINE_P)
 
 /* 8.7: Block Data Put Routines */
-void shmem_float_put(float *target, const float *source, size_t len, int pe)
-{
-    oshmpi_put(MPI_FLOAT, target, source, len, pe);
-}
-void shmem_double_put(double *target, const double *source, size_t len, int pe)
-{
-    oshmpi_put(MPI_DOUBLE, target, source, len, pe);
-}
-void shmem_longdouble_put(long double *target, const long double *source, size_t len, int pe)
-{
-    oshmpi_put(MPI_LONG_DOUBLE, target, source, len, pe);
-}
-void shmem_char_put(char *target, const char *source, size_t len, int pe)
-{
-    oshmpi_put(MPI_CHAR, target, source, len, pe);
-}
-void shmem_short_put(short *target, const short *source, size_t len, int pe)
-{
-    oshmpi_put(MPI_SHORT, target, source, len, pe);
-}
-void shmem_int_put(int *target, const int *source, size_t len, int pe)
-{
-    oshmpi_put(MPI_INT, target, source, len, pe);
-}
-void shmem_long_put(long *target, const long *source, size_t len, int pe)
-{
-    oshmpi_put(MPI_LONG, target, source, len, pe);
-}
-void shmem_longlong_put(long long *target, const long long *source, size_t len, int pe)
-{
-    oshmpi_put(MPI_LONG_LONG, target, source, len, pe);
-}
+#define OSHMPI_DEFINE_PUT(NAME, TYPE, MPI_TYPE)                                     \
+void shmem_##NAME##_put(TYPE *target, const TYPE *source, size_t len, int pe)       \
+{                                                                                   \
+    oshmpi_typed_put(MPI_TYPE, sizeof(TYPE), target, source, len, pe);             \
+}
+#define OSHMPI_DEFINE_PUTN(BITS, TYPE, MPI_TYPE)                                    \
+void shmem_put##BITS(void *target, const void *source, size_t len, int pe)          \
+{                                                                                   \
+    oshmpi_typed_put(MPI_TYPE, sizeof(TYPE), target, source, len, pe);             \
+}
+OSHMPI_RMA_TYPES(OSHMPI_DEFINE_PUT)
+OSHMPI_COMPLEX_TYPES(OSHMPI_DEFINE_PUT)
+OSHMPI_SIZED_TYPES(OSHMPI_DEFINE_PUTN)
 void shmem_putmem(void *target, const void *source, size_t len, int pe)
 {
-    oshmpi_put(MPI_BYTE, target, source, len, pe);
-}
-void shmem_put32(void *target, const void *source, size_t len, int pe)
-{
-    oshmpi_put(MPI_INT32_T, target, source, len, pe);
-}
-void shmem_put64(void *target, const void *source, size_t len, int pe)
-{
-    oshmpi_put(MPI_DOUBLE, target, source, len, pe);
-}
-void shmem_put128(void *target, const void *source, size_t len, int pe)
-{
-    oshmpi_put(MPI_C_DOUBLE_COMPLEX, target, source, len, pe);
-}
-void shmem_complexf_put(float complex * target, const float complex * source, size_t len, int pe)
-{
-    oshmpi_put(MPI_COMPLEX, target, source, len, pe);
-}
-void shmem_complexd_put(double complex * target, const double complex * source, size_t len, int pe)
-{
-    oshmpi_put(MPI_DOUBLE_COMPLEX, target, source, len, pe);
+    oshmpi_typed_put(MPI_BYTE, 1, target, source, len, pe);
 }
 
 /* 8.9: Elemental Data Get Routines */
-float shmem_float_g(float *addr, int pe)
-{
-    float v;
-    oshmpi_get(MPI_FLOAT, &v, addr, 1, pe);
-    return v;
-}
-double shmem_double_g(double *addr, int pe)
-{
-    double v;
-    oshmpi_get(MPI_DOUBLE, &v, addr, 1, pe);
-    return v;
-}
-long double shmem_longdouble_g(long double *addr, int pe)
-{
-    long double v;
-    oshmpi_get(MPI_LONG_DOUBLE, &v, addr, 1, pe);
-    return v;
-}
-char shmem_char_g(char *addr, int pe)
-{
-    char v;
-    oshmpi_get(MPI_CHAR, &v, addr, 1, pe);
-    return v;
-}
-short shmem_short_g(short *addr, int pe)
-{
-    short v;
-    oshmpi_get(MPI_SHORT, &v, addr, 1, pe);
-    return v;
-}
-int shmem_int_g(int *addr, int pe)
-{
-    int v;
-    oshmpi_get(MPI_INT, &v, addr, 1, pe);
-    return v;
-}
-long shmem_long_g(long *addr, int pe)
-{
-    long v;
-    oshmpi_get(MPI_LONG, &v, addr, 1, pe);
-    return v;
-}
-long long shmem_longlong_g(long long *addr, int pe)
-{
-    long long v;
-    oshmpi_get(MPI_LONG_LONG, &v, addr, 1, pe);
-    return v;
+#define OSHMPI_DEFINE_G(NAME, TYPE, MPI_TYPE)                                       \
+TYPE shmem_##NAME##_g(TYPE *addr, int pe)                                           \
+{                                                                                   \
+    TYPE v;                                                                         \
+    oshmpi_typed_get(MPI_TYPE, sizeof(TYPE), &v, addr, 1, pe);                      \
+    return v;                                                                       \
 }
+OSHMPI_RMA_TYPES(OSHMPI_DEFINE_G)
 
 /* 8.10 Block Data Get Routines */
-void shmem_float_get(float *target, const float *source, size_t len, int pe)
-{
-    oshmpi_get(MPI_FLOAT, target, source, len, pe);
-}
-void shmem_double_get(double *target, const double *source, size_t len, int pe)
-{
-    oshmpi_get(MPI_DOUBLE, target, source, len, pe);
-}
-void shmem_longdouble_get(long double *target, const long double *source, size_t len, int pe)
-{
-    oshmpi_get(MPI_LONG_DOUBLE, target, source, len, pe);
-}
-void shmem_char_get(char *target, const char *source, size_t len, int pe)
-{
-    oshmpi_get(MPI_CHAR, target, source, len, pe);
-}
-void shmem_short_get(short *target, const short *source, size_t len, int pe)
-{
-    oshmpi_get(MPI_SHORT, target, source, len, pe);
-}
-void shmem_int_get(int *target, const int *source, size_t len, int pe)
-{
-    oshmpi_get(MPI_INT, target, source, len, pe);
-}
-void shmem_long_get(long *target, const long *source, size_t len, int pe)
-{
-    oshmpi_get(MPI_LONG, target, source, len, pe);
-}
-void shmem_longlong_get(long long *target, const long long *source, size_t len, int pe)
-{
-    oshmpi_get(MPI_LONG_LONG, target, source, len, pe);
-}
+#define OSHMPI_DEFINE_GET(NAME, TYPE, MPI_TYPE)                                     \
+void shmem_##NAME##_get(TYPE *target, const TYPE *source, size_t len, int pe)       \
+{                                                                                   \
+    oshmpi_typed_get(MPI_TYPE, sizeof(TYPE), target, source, len, pe);             \
+}
+#define OSHMPI_DEFINE_GETN(BITS, TYPE, MPI_TYPE)                                    \
+void shmem_get##BITS(void *target, const void *source, size_t len, int pe)          \
+{                                                                                   \
+    oshmpi_typed_get(MPI_TYPE, sizeof(TYPE), target, source, len, pe);             \
+}
+OSHMPI_RMA_TYPES(OSHMPI_DEFINE_GET)
+OSHMPI_COMPLEX_TYPES(OSHMPI_DEFINE_GET)
+OSHMPI_SIZED_TYPES(OSHMPI_DEFINE_GETN)
 void shmem_getmem(void *target, const void *source, size_t len, int pe)
 {
-    oshmpi_get(MPI_BYTE, target, source, len, pe);
-}
-void shmem_get32(void *target, const void *source, size_t len, int pe)
-{
-    oshmpi_get(MPI_INT32_T, target, source, len, pe);
-}
-void shmem_get64(void *target, const void *source, size_t len, int pe)
-{
-    oshmpi_get(MPI_DOUBLE, target, source, len, pe);
-}
-void shmem_get128(void *target, const void *source, size_t len, int pe)
-{
-    oshmpi_get(MPI_C_DOUBLE_COMPLEX, target, source, len, pe);
-}
-void shmem_complexf_get(float complex * target, const float complex * source, size_t len, int pe)
-{
-    oshmpi_get(MPI_COMPLEX, target, source, len, pe);
-}
-void shmem_complexd_get(double complex * target, const double complex * source, size_t len, int pe)
-{
-    oshmpi_get(MPI_DOUBLE_COMPLEX, target, source, len, pe);
+    oshmpi_typed_get(MPI_BYTE, 1, target, source, len, pe);
 }
 
 /* 8.8: Strided Put Routines */
-void shmem_float_iput(float *target, const float *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_put_strided(MPI_FLOAT, target, source, tst, sst, len, pe);
-}
-void shmem_double_iput(double *target, const double *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_put_strided(MPI_DOUBLE, target, source, tst, sst, len, pe);
-}
-void shmem_longdouble_iput(long double *target, const long double *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_put_strided(MPI_LONG_DOUBLE, target, source, tst, sst, len, pe);
-}
-void shmem_short_iput(short *target, const short *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_put_strided(MPI_SHORT, target, source, tst, sst, len, pe);
-}
-void shmem_int_iput(int *target, const int *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_put_strided(MPI_INT, target, source, tst, sst, len, pe);
+#define OSHMPI_DEFINE_IPUT(NAME, TYPE, MPI_TYPE)                                    \
+void shmem_##NAME##_iput(TYPE *target, const TYPE *source,                          \
+                         ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)          \
+{                                                                                   \
+    oshmpi_typed_put_strided(MPI_TYPE, sizeof(TYPE), target, source, tst, sst, len, pe); \
 }
-void shmem_long_iput(long *target, const long *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_put_strided(MPI_LONG, target, source, tst, sst, len, pe);
-}
-void shmem_longlong_iput(long long *target, const long long *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_put_strided(MPI_LONG_LONG, target, source, tst, sst, len, pe);
-}
-void shmem_iput32(void *target, const void *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_put_strided(MPI_INT32_T, target, source, tst, sst, len, pe);
-}
-void shmem_iput64(void *target, const void *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    /* FIXME Why not MPI_INT64_T ? */
-    oshmpi_put_strided(MPI_DOUBLE, target, source, tst, sst, len, pe);
-}
-void shmem_iput128(void *target, const void *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    /* FIXME Why not use MPI_INT64_T and len*=2 ?
-     * I recall something we tried before didn't work, but what was it? */
-    oshmpi_put_strided(MPI_C_DOUBLE_COMPLEX, target, source, tst, sst, len, pe);
+#define OSHMPI_DEFINE_IPUTN(BITS, TYPE, MPI_TYPE)                                   \
+void shmem_iput##BITS(void *target, const void *source,                             \
+                      ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)             \
+{                                                                                   \
+    oshmpi_typed_put_strided(MPI_TYPE, sizeof(TYPE), target, source, tst, sst, len, pe); \
 }
+OSHMPI_RMA_TYPES(OSHMPI_DEFINE_IPUT)
+OSHMPI_SIZED_TYPES(OSHMPI_DEFINE_IPUTN)
 
 /* 8.11: Strided Get Routines */
-void shmem_float_iget(float *target, const float *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_get_strided(MPI_FLOAT, target, source, tst, sst, len, pe);
-}
-void shmem_double_iget(double *target, const double *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_get_strided(MPI_DOUBLE, target, source, tst, sst, len, pe);
+#define OSHMPI_DEFINE_IGET(NAME, TYPE, MPI_TYPE)                                    \
+void shmem_##NAME##_iget(TYPE *target, const TYPE *source,                          \
+                         ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)          \
+{                                                                                   \
+    oshmpi_typed_get_strided(MPI_TYPE, sizeof(TYPE), target, source, tst, sst, len, pe); \
 }
-void shmem_longdouble_iget(long double *target, const long double *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_get_strided(MPI_LONG_DOUBLE, target, source, tst, sst, len, pe);
-}
-void shmem_short_iget(short *target, const short *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_get_strided(MPI_SHORT, target, source, tst, sst, len, pe);
-}
-void shmem_int_iget(int *target, const int *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_get_strided(MPI_INT, target, source, tst, sst, len, pe);
-}
-void shmem_long_iget(long *target, const long *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_get_strided(MPI_LONG, target, source, tst, sst, len, pe);
-}
-void shmem_longlong_iget(long long *target, const long long *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_get_strided(MPI_LONG_LONG, target, source, tst, sst, len, pe);
-}
-void shmem_iget32(void *target, const void *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_get_strided(MPI_INT32_T, target, source, tst, sst, len, pe);
-}
-void shmem_iget64(void *target, const void *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_get_strided(MPI_DOUBLE, target, source, tst, sst, len, pe);
-}
-void shmem_iget128(void *target, const void *source, ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)
-{
-    oshmpi_get_strided(MPI_C_DOUBLE_COMPLEX, target, source, tst, sst, len, pe);
+#define OSHMPI_DEFINE_IGETN(BITS, TYPE, MPI_TYPE)                                   \
+void shmem_iget##BITS(void *target, const void *source,                             \
+                      ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe)             \
+{                                                                                   \
+    oshmpi_typed_get_strided(MPI_TYPE, sizeof(TYPE), target, source, tst, sst, len, pe); \
 }
+OSHMPI_RMA_TYPES(OSHMPI_DEFINE_IGET)
+OSHMPI_SIZED_TYPES(OSHMPI_DEFINE_IGETN)
 
 /* Naming conventions for shorthand:
  * r = return v
@@ -445,135 +375,91 @@ void shmem_iget128(void *target, const void *source, ptrdiff_t tst, ptrdiff_t ss
  */
 
 /* 8.12: Atomic Memory fetch-and-operate Routines -- Swap */
-float shmem_float_swap(float *t, float v, int pe)
-{
-    float r;
-    oshmpi_swap(MPI_FLOAT, &r, t, &v, pe) ;
-    return r;
-}
-double shmem_double_swap(double *t, double v, int pe)
-{
-    double r;
-    oshmpi_swap(MPI_DOUBLE, &r, t, &v, pe) ;
-    return r;
-}
-int shmem_int_swap(int *t, int v, int pe)
-{
-    int r;
-    oshmpi_swap(MPI_INT, &r, t, &v, pe) ;
-    return r;
-}
-long shmem_long_swap(long *t, long v, int pe)
-{
-    long r;
-    oshmpi_swap(MPI_LONG, &r, t, &v, pe) ;
-    return r;
-}
-long long shmem_longlong_swap(long long *t, long long v, int pe)
-{
-    long long r;
-    oshmpi_swap(MPI_LONG_LONG, &r, t, &v, pe) ;
-    return r;
-}
+#define OSHMPI_DEFINE_SWAP(NAME, TYPE, MPI_TYPE, WORD)                              \
+TYPE shmem_##NAME##_swap(TYPE *t, TYPE v, int pe)                                   \
+{                                                                                   \
+    WORD * ptr = oshmpi_smp_ptr(t, pe);                                             \
+    TYPE r;                                                                         \
+    if (ptr!=NULL) {                                                                \
+        union { TYPE v; WORD w; } in, out;                                          \
+        in.v  = v;                                                                  \
+        out.w = __sync_lock_test_and_set(ptr, in.w);                                \
+        r = out.v;                                                                  \
+        oshmpi_wait_wake(pe);                                                       \
+    } else {                                                                        \
+        oshmpi_swap(MPI_TYPE, &r, t, &v, pe);                                       \
+    }                                                                               \
+    return r;                                                                       \
+}
+OSHMPI_SWAP_TYPES(OSHMPI_DEFINE_SWAP)
 long shmem_swap(long *t, long v, int pe)
 {
-    long r;
-    oshmpi_swap(MPI_LONG, &r, t, &v, pe) ;
-    return r;
+    return shmem_long_swap(t, v, pe);
 }
 
 /* 8.12: Atomic Memory fetch-and-operate Routines -- Cswap */
-int shmem_int_cswap(int *t, int c, int v, int pe)
-{
-    int r;
-    oshmpi_cswap(MPI_INT, &r, t, &v, &c, pe) ;
-    return r;
-}
-long shmem_long_cswap(long *t, long c, long v, int pe)
-{
-    long r;
-    oshmpi_cswap(MPI_LONG, &r, t, &v, &c, pe) ;
-    return r;
-}
-long long shmem_longlong_cswap(long long * t, long long c, long long v, int pe)
-{
-    long long r;
-    oshmpi_cswap(MPI_LONG_LONG, &r, t, &v, &c, pe) ;
-    return r;
-}
+#define OSHMPI_DEFINE_CSWAP(NAME, TYPE, MPI_TYPE)                                   \
+TYPE shmem_##NAME##_cswap(TYPE *t, TYPE c, TYPE v, int pe)                          \
+{                                                                                   \
+    TYPE * ptr = oshmpi_smp_ptr(t, pe);                                             \
+    TYPE r;                                                                         \
+    if (ptr!=NULL) {                                                                \
+        r = __sync_val_compare_and_swap(ptr, c, v);                                 \
+        oshmpi_wait_wake(pe);                                                       \
+    } else {                                                                        \
+        oshmpi_cswap(MPI_TYPE, &r, t, &v, &c, pe);                                  \
+    }                                                                               \
+    return r;                                                                       \
+}
+OSHMPI_AMO_TYPES(OSHMPI_DEFINE_CSWAP)
 
 #ifndef USE_SAME_OP_NO_OP
 
 /* 8.12: Atomic Memory fetch-and-operate Routines -- Fetch and Add */
-int shmem_int_fadd(int *t, int v, int pe)
-{
-    int r;
-    oshmpi_fadd(MPI_INT, &r, t, &v, pe);
-    return r;
-}
-long shmem_long_fadd(long *t, long v, int pe)
-{
-    long r;
-    oshmpi_fadd(MPI_LONG, &r, t, &v, pe);
-    return r;
-}
-long long shmem_longlong_fadd(long long *t, long long v, int pe)
-{
-    long long r;
-    oshmpi_fadd(MPI_LONG_LONG, &r, t, &v, pe);
-    return r;
-}
+#define OSHMPI_DEFINE_FADD(NAME, TYPE, MPI_TYPE)                                    \
+TYPE shmem_##NAME##_fadd(TYPE *t, TYPE v, int pe)                                   \
+{                                                                                   \
+    TYPE * ptr = oshmpi_smp_ptr(t, pe);                                             \
+    TYPE r;                                                                         \
+    if (ptr!=NULL) {                                                                \
+        r = __sync_fetch_and_add(ptr, v);                                           \
+        oshmpi_wait_wake(pe);                                                       \
+    } else {                                                                        \
+        oshmpi_fadd(MPI_TYPE, &r, t, &v, pe);                                       \
+    }                                                                               \
+    return r;                                                                       \
+}
+OSHMPI_AMO_TYPES(OSHMPI_DEFINE_FADD)
 
 /* 8.12: Atomic Memory fetch-and-operate Routines -- Fetch and Increment */
-int shmem_int_finc(int *t, int pe)
-{
-    int r, v=1;
-    oshmpi_fadd(MPI_INT, &r, t, &v, pe);
-    return r;
-}
-long shmem_long_finc(long *t, int pe)
-{
-    long r, v=1;
-    oshmpi_fadd(MPI_LONG, &r, t, &v, pe);
-    return r;
-}
-long long shmem_longlong_finc(long long *t, int pe)
-{
-    long long r, v=1;
-    oshmpi_fadd(MPI_LONG_LONG, &r, t, &v, pe);
-    return r;
+#define OSHMPI_DEFINE_FINC(NAME, TYPE, MPI_TYPE)                                    \
+TYPE shmem_##NAME##_finc(TYPE *t, int pe)                                           \
+{                                                                                   \
+    return shmem_##NAME##_fadd(t, 1, pe);                                           \
 }
+OSHMPI_AMO_TYPES(OSHMPI_DEFINE_FINC)
 
 /* 8.13: Atomic Memory Operation Routines -- Add */
-void shmem_int_add(int *t, int v, int pe)
-{
-    oshmpi_add(MPI_INT, t, &v, pe);
-}
-void shmem_long_add(long *t, long v, int pe)
-{
-    oshmpi_add(MPI_LONG, t, &v, pe);
-}
-void shmem_longlong_add(long long *t, long long v, int pe)
-{
-    oshmpi_add(MPI_LONG_LONG, t, &v, pe);
-}
+#define OSHMPI_DEFINE_ADD(NAME, TYPE, MPI_TYPE)                                     \
+void shmem_##NAME##_add(TYPE *t, TYPE v, int pe)                                    \
+{                                                                                   \
+    TYPE * ptr = oshmpi_smp_ptr(t, pe);                                             \
+    if (ptr!=NULL) {                                                                \
+        __sync_fetch_and_add(ptr, v);                                               \
+        oshmpi_wait_wake(pe);                                                       \
+    } else {                                                                        \
+        oshmpi_add(MPI_TYPE, t, &v, pe);                                            \
+    }                                                                               \
+}
+OSHMPI_AMO_TYPES(OSHMPI_DEFINE_ADD)
 
 /* 8.13: Atomic Memory Operation Routines -- Increment */
-void shmem_int_inc(int *t, int pe)
-{
-    int v=1;
-    oshmpi_add(MPI_INT, t, &v, pe);
-}
-void shmem_long_inc(long *t, int pe)
-{
-    long v=1;
-    oshmpi_add(MPI_LONG, t, &v, pe);
-}
-void shmem_longlong_inc(long long *t, int pe)
-{
-    long long v=1;
-    oshmpi_add(MPI_LONG_LONG, t, &v, pe);
+#define OSHMPI_DEFINE_INC(NAME, TYPE, MPI_TYPE)                                     \
+void shmem_##NAME##_inc(TYPE *t, int pe)                                            \
+{                                                                                   \
+    shmem_##NAME##_add(t, 1, pe);                                                   \
 }
+OSHMPI_AMO_TYPES(OSHMPI_DEFINE_INC)
 
 #else
 
@@ -605,6 +491,44 @@ void shmem_longlong_wait_until(long long *var, int c, long long v)
 void shmem_wait_until(long *var, int c, long v)
 { long t; SHMEM_WAIT_UNTIL(var, c, v, t, MPI_LONG); }
 
+/* 8.14: Point-to-Point Synchronization Routines -- Test */
+int shmem_short_test(short *var, int c, short v)
+{ int r; SHMEM_TEST(short, var, c, v, r); return r; }
+int shmem_int_test(int *var, int c, int v)
+{ int r; SHMEM_TEST(int, var, c, v, r); return r; }
+int shmem_long_test(long *var, int c, long v)
+{ int r; SHMEM_TEST(long, var, c, v, r); return r; }
+int shmem_longlong_test(long long *var, int c, long long v)
+{ int r; SHMEM_TEST(long long, var, c, v, r); return r; }
+
+/* 8.14: Point-to-Point Synchronization Routines -- Wait Until Any/All/Some */
+size_t shmem_short_wait_until_any(short *vars, size_t n, const int *s, int c, short v)
+{ size_t r; SHMEM_WAIT_UNTIL_ANY(short, vars, n, s, c, v, r); return r; }
+size_t shmem_int_wait_until_any(int *vars, size_t n, const int *s, int c, int v)
+{ size_t r; SHMEM_WAIT_UNTIL_ANY(int, vars, n, s, c, v, r); return r; }
+size_t shmem_long_wait_until_any(long *vars, size_t n, const int *s, int c, long v)
+{ size_t r; SHMEM_WAIT_UNTIL_ANY(long, vars, n, s, c, v, r); return r; }
+size_t shmem_longlong_wait_until_any(long long *vars, size_t n, const int *s, int c, long long v)
+{ size_t r; SHMEM_WAIT_UNTIL_ANY(long long, vars, n, s, c, v, r); return r; }
+
+void shmem_short_wait_until_all(short *vars, size_t n, const int *s, int c, short v)
+{ SHMEM_WAIT_UNTIL_ALL(short, vars, n, s, c, v); }
+void shmem_int_wait_until_all(int *vars, size_t n, const int *s, int c, int v)
+{ SHMEM_WAIT_UNTIL_ALL(int, vars, n, s, c, v); }
+void shmem_long_wait_until_all(long *vars, size_t n, const int *s, int c, long v)
+{ SHMEM_WAIT_UNTIL_ALL(long, vars, n, s, c, v); }
+void shmem_longlong_wait_until_all(long long *vars, size_t n, const int *s, int c, long long v)
+{ SHMEM_WAIT_UNTIL_ALL(long long, vars, n, s, c, v); }
+
+size_t shmem_short_wait_until_some(short *vars, size_t n, size_t *idx, const int *s, int c, short v)
+{ size_t r; SHMEM_WAIT_UNTIL_SOME(short, vars, n, idx, s, c, v, r); return r; }
+size_t shmem_int_wait_until_some(int *vars, size_t n, size_t *idx, const int *s, int c, int v)
+{ size_t r; SHMEM_WAIT_UNTIL_SOME(int, vars, n, idx, s, c, v, r); return r; }
+size_t shmem_long_wait_until_some(long *vars, size_t n, size_t *idx, const int *s, int c, long v)
+{ size_t r; SHMEM_WAIT_UNTIL_SOME(long, vars, n, idx, s, c, v, r); return r; }
+size_t shmem_longlong_wait_until_some(long long *vars, size_t n, size_t *idx, const int *s, int c, long long v)
+{ size_t r; SHMEM_WAIT_UNTIL_SOME(long long, vars, n, idx, s, c, v, r); return r; }
+
 /* 8.15: Barrier Synchronization Routines */
 
 void shmem_barrier(int PE_start, int logPE_stride, int PE_size, long *pSync)
@@ -619,7 +543,11 @@ void shmem_barrier_all(void)
 {
     oshmpi_remote_sync();
     oshmpi_local_sync();
-    MPI_Barrier(SHMEM_COMM_WORLD);
+    if (oshmpi_etext_unsettled()) {
+        oshmpi_etext_barrier(0, 0, shmem_world_size);
+    } else {
+        MPI_Barrier(SHMEM_COMM_WORLD);
+    }
     //oshmpi_coll(SHMEM_BARRIER, MPI_DATATYPE_NULL, MPI_OP_NULL, NULL, NULL, 0 /* count */, -1 /* root */, 0, 0, shmem_world_size );
 }
 
@@ -18,7 +18,9 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#ifndef __cplusplus
 #include <complex.h>
+#endif
 #include <assert.h>
 
 /* These few lines and the ones they replaced are the only changes to this file. */
@@ -39,6 +41,17 @@
 #endif
 /* -- end changes -- */
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* See shmem-inline.h.  The library always builds the out-of-line versions. */
+#if defined(OSHMPI_INLINE) && defined(__GNUC__) && !defined(OSHMPI_BUILDING_LIBRARY)
+#define OSHMPI_HAVE_INLINE 1
+#else
+#define OSHMPI_HAVE_INLINE 0
+#endif
+
 #define SHMEM_CMP_EQ 1
 #define SHMEM_CMP_NE 2
 #define SHMEM_CMP_GT 3
@@ -90,6 +103,7 @@ void shfree(void *ptr);
 void *shmem_ptr(void *target, int pe);
 
 /* 8.6: Elemental Put Routines */
+#if !OSHMPI_HAVE_INLINE
 void shmem_float_p(float *addr, float value, int pe);
 void shmem_double_p(double *addr, double value, int pe);
 void shmem_longdouble_p(long double *addr, long double value, int pe);
@@ -98,6 +112,7 @@ void shmem_short_p(short *addr, short value, int pe);
 void shmem_int_p(int *addr, int value, int pe);
 void shmem_long_p(long *addr, long value, int pe);
 void shmem_longlong_p(long long *addr, long long value, int pe);
+#endif
 
 /* 8.7: Block Data Put Routines */
 void shmem_float_put(float *target, const float *source, size_t len, int pe);
@@ -115,10 +130,12 @@ void shmem_put32(void *target, const void *source, size_t len, int pe);
 void shmem_put64(void *target, const void *source, size_t len, int pe);
 void shmem_put128(void *target, const void *source, size_t len, int pe);
 void shmem_putmem(void *target, const void *source, size_t len, int pe);
+#ifndef __cplusplus /* C99 complex types */
 void shmem_complexf_put(float complex * target,
                         const float complex * source, size_t nelems, int pe);
 void shmem_complexd_put(double complex * target,
                         const double complex * source, size_t nelems, int pe);
+#endif
 
 /* 8.8: Strided Put Routines */
 void shmem_float_iput(float *target, const float *source, ptrdiff_t tst,
@@ -127,6 +144,8 @@ void shmem_double_iput(double *target, const double *source, ptrdiff_t tst,
                        ptrdiff_t sst, size_t len, int pe);
 void shmem_longdouble_iput(long double *target, const long double *source,
                            ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe);
+void shmem_char_iput(char *target, const char *source, ptrdiff_t tst,
+                     ptrdiff_t sst, size_t len, int pe);
 void shmem_short_iput(short *target, const short *source, ptrdiff_t tst,
                       ptrdiff_t sst, size_t len, int pe);
 void shmem_int_iput(int *target, const int *source, ptrdiff_t tst,
@@ -143,6 +162,7 @@ void shmem_iput128(void *target, const void *source, ptrdiff_t tst,
                    ptrdiff_t sst, size_t len, int pe);
 
 /* 8.9: Elemental Data Get Routines */
+#if !OSHMPI_HAVE_INLINE
 float shmem_float_g(float *addr, int pe);
 double shmem_double_g(double *addr, int pe);
 long double shmem_longdouble_g(long double *addr, int pe);
@@ -151,6 +171,7 @@ short shmem_short_g(short *addr, int pe);
 int shmem_int_g(int *addr, int pe);
 long shmem_long_g(long *addr, int pe);
 long long shmem_longlong_g(long long *addr, int pe);
+#endif
 
 /* 8.10 Block Data Get Routines */
 void shmem_float_get(float *target, const float *source, size_t len, int pe);
@@ -168,10 +189,12 @@ void shmem_get32(void *target, const void *source, size_t len, int pe);
 void shmem_get64(void *target, const void *source, size_t len, int pe);
 void shmem_get128(void *target, const void *source, size_t len, int pe);
 void shmem_getmem(void *target, const void *source, size_t len, int pe);
+#ifndef __cplusplus /* C99 complex types */
 void shmem_complexf_get(float complex * target,
                         const float complex * source, size_t nelems, int pe);
 void shmem_complexd_get(double complex * target,
                         const double complex * source, size_t nelems, int pe);
+#endif
 
 /* 8.11: Strided Get Routines */
 void shmem_float_iget(float *target, const float *source, ptrdiff_t tst,
@@ -180,6 +203,8 @@ void shmem_double_iget(double *target, const double *source, ptrdiff_t tst,
                        ptrdiff_t sst, size_t len, int pe);
 void shmem_longdouble_iget(long double *target, const long double *source,
                            ptrdiff_t tst, ptrdiff_t sst, size_t len, int pe);
+void shmem_char_iget(char *target, const char *source, ptrdiff_t tst,
+                     ptrdiff_t sst, size_t len, int pe);
 void shmem_short_iget(short *target, const short *source, ptrdiff_t tst,
                       ptrdiff_t sst, size_t len, int pe);
 void shmem_int_iget(int *target, const int *source, ptrdiff_t tst,
@@ -198,12 +223,15 @@ void shmem_iget128(void *target, const void *source, ptrdiff_t tst,
 /* 8.12: Atomic Memory fetch-and-operate Routines -- Swap */
 float shmem_float_swap(float *target, float value, int pe);
 double shmem_double_swap(double *target, double value, int pe);
+#if !OSHMPI_HAVE_INLINE
 int shmem_int_swap(int *target, int value, int pe);
 long shmem_long_swap(long *target, long value, int pe);
 long long shmem_longlong_swap(long long *target, long long value, int pe);
 long shmem_swap(long *target, long value, int pe);
+#endif
 
 /* 8.12: Atomic Memory fetch-and-operate Routines -- Cswap */
+#if !OSHMPI_HAVE_INLINE
 int shmem_int_cswap(int *target, int cond, int value, int pe);
 long shmem_long_cswap(long *target, long cond, long value, int pe);
 long long shmem_longlong_cswap(long long * target, long long cond, 
@@ -228,6 +256,7 @@ void shmem_longlong_add(long long *target, long long value, int pe);
 void shmem_int_inc(int *target, int pe);
 void shmem_long_inc(long *target, int pe);
 void shmem_longlong_inc(long long *target, int pe);
+#endif
 
 /* 8.14: Point-to-Point Synchronization Routines -- Wait*/
 void shmem_short_wait(short *var, short value);
@@ -244,6 +273,40 @@ void shmem_longlong_wait_until(long long *var, int cond,
                                long long value);
 void shmem_wait_until(long *ivar, int cmp, long value);
 
+/* 8.14: Point-to-Point Synchronization Routines -- Test */
+int shmem_short_test(short *ivar, int cmp, short cmp_value);
+int shmem_int_test(int *ivar, int cmp, int cmp_value);
+int shmem_long_test(long *ivar, int cmp, long cmp_value);
+int shmem_longlong_test(long long *ivar, int cmp, long long cmp_value);
+
+/* 8.14: Point-to-Point Synchronization Routines -- Wait Until Any/All/Some */
+size_t shmem_short_wait_until_any(short *ivars, size_t nelems, const int *status,
+                                  int cmp, short cmp_value);
+size_t shmem_int_wait_until_any(int *ivars, size_t nelems, const int *status,
+                                int cmp, int cmp_value);
+size_t shmem_long_wait_until_any(long *ivars, size_t nelems, const int *status,
+                                 int cmp, long cmp_value);
+size_t shmem_longlong_wait_until_any(long long *ivars, size_t nelems, const int *status,
+                                     int cmp, long long cmp_value);
+
+void shmem_short_wait_until_all(short *ivars, size_t nelems, const int *status,
+                                int cmp, short cmp_value);
+void shmem_int_wait_until_all(int *ivars, size_t nelems, const int *status,
+                              int cmp, int cmp_value);
+void shmem_long_wait_until_all(long *ivars, size_t nelems, const int *status,
+                               int cmp, long cmp_value);
+void shmem_longlong_wait_until_all(long long *ivars, size_t nelems, const int *status,
+                                   int cmp, long long cmp_value);
+
+size_t shmem_short_wait_until_some(short *ivars, size_t nelems, size_t *indices,
+                                   const int *status, int cmp, short cmp_value);
+size_t shmem_int_wait_until_some(int *ivars, size_t nelems, size_t *indices,
+                                 const int *status, int cmp, int cmp_value);
+size_t shmem_long_wait_until_some(long *ivars, size_t nelems, size_t *indices,
+                                  const int *status, int cmp, long cmp_value);
+size_t shmem_longlong_wait_until_some(long long *ivars, size_t nelems, size_t *indices,
+                                      const int *status, int cmp, long long cmp_value);
+
 /* 8.15: Barrier Synchronization Routines */
 void shmem_barrier(int PE_start, int logPE_stride, int PE_size, long *pSync);
 void shmem_barrier_all(void);
@@ -344,12 +407,14 @@ void shmem_double_sum_to_all(double *target, double *source, int nreduce,
 void shmem_longdouble_sum_to_all(long double *target, long double *source,
                                  int nreduce, int PE_start, int logPE_stride,
                                  int PE_size, long double *pWrk, long *pSync);
+#ifndef __cplusplus /* C99 complex types */
 void shmem_complexf_sum_to_all(float complex *target, float complex *source,
                                int nreduce, int PE_start, int logPE_stride,
                                int PE_size, float complex *pWrk, long *pSync);
 void shmem_complexd_sum_to_all(double complex *target, double complex *source,
                                int nreduce, int PE_start, int logPE_stride,
                                int PE_size, double complex *pWrk, long *pSync);
+#endif
 void shmem_short_sum_to_all(short *target, short *source, int nreduce, 
                             int PE_start, int logPE_stride, int PE_size, 
                             short *pWrk, long *pSync);
@@ -372,6 +437,7 @@ void shmem_double_prod_to_all(double *target, double *source, int nreduce,
 void shmem_longdouble_prod_to_all(long double *target, long double *source,
                                   int nreduce, int PE_start, int logPE_stride,
                                   int PE_size, long double *pWrk, long *pSync);
+#ifndef __cplusplus /* C99 complex types */
 void shmem_complexf_prod_to_all(float complex *target, float complex *source,
                                 int nreduce, int PE_start, int logPE_stride,
                                 int PE_size, float complex *pWrk, long *pSync);
@@ -379,6 +445,7 @@ void shmem_complexd_prod_to_all(double complex *target,
                                 double complex *source, int nreduce, 
                                 int PE_start, int logPE_stride, int PE_size, 
                                 double complex *pWrk, long *pSync);
+#endif
 void shmem_short_prod_to_all(short *target, short *source, int nreduce, 
                              int PE_start, int logPE_stride, int PE_size, 
                              short *pWrk, long *pSync);
@@ -429,4 +496,10 @@ void shmem_udcflush_line(void *target) __attribute__ ((deprecated));
 double shmem_wtime(void);
 char* shmem_nodename(void);
 
+#include "shmem-inline.h"
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* OSHMPI_SHMEM_H */
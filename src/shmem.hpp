@@ -0,0 +1,285 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#ifndef OSHMPI_SHMEM_HPP
+#define OSHMPI_SHMEM_HPP
+
+/* C++11 interface to OSHMPI.
+ *
+ * Everything here is a template or inline function that resolves at compile
+ * time to one of the typed C entry points, so generic code compiles to the
+ * same calls as hand-typed C (and with -DOSHMPI_INLINE, to the same inlined
+ * load-store paths).  There is no virtual dispatch and nothing is copied. */
+
+#include <cstddef>
+#include <complex>
+#include <new>
+#include <type_traits>
+
+#include "shmem.h"
+#include "shmem-types.h"
+
+/* shmem.h hides these from C++ because it has no C99 complex,
+ * but std::complex<T> has the same layout as T _Complex. */
+extern "C" {
+void shmem_complexf_put(std::complex<float> *target, const std::complex<float> *source, size_t nelems, int pe);
+void shmem_complexd_put(std::complex<double> *target, const std::complex<double> *source, size_t nelems, int pe);
+void shmem_complexf_get(std::complex<float> *target, const std::complex<float> *source, size_t nelems, int pe);
+void shmem_complexd_get(std::complex<double> *target, const std::complex<double> *source, size_t nelems, int pe);
+void shmem_complexf_sum_to_all(std::complex<float> *target, std::complex<float> *source, int nreduce,
+                               int PE_start, int logPE_stride, int PE_size, std::complex<float> *pWrk, long *pSync);
+void shmem_complexd_sum_to_all(std::complex<double> *target, std::complex<double> *source, int nreduce,
+                               int PE_start, int logPE_stride, int PE_size, std::complex<double> *pWrk, long *pSync);
+void shmem_complexf_prod_to_all(std::complex<float> *target, std::complex<float> *source, int nreduce,
+                                int PE_start, int logPE_stride, int PE_size, std::complex<float> *pWrk, long *pSync);
+void shmem_complexd_prod_to_all(std::complex<double> *target, std::complex<double> *source, int nreduce,
+                                int PE_start, int logPE_stride, int PE_size, std::complex<double> *pWrk, long *pSync);
+}
+
+namespace oshmpi {
+
+/*****************************************************************/
+/* Symmetric arrays */
+
+namespace detail {
+/* Whether ok is true on every PE.  Collective over all PEs, and it
+ * synchronizes like a barrier, since OSHMPI reduces with MPI_Allreduce. */
+inline bool all_pes(bool ok)
+{
+    static long psync[_SHMEM_REDUCE_SYNC_SIZE] = { _SHMEM_SYNC_VALUE };
+    static int  pwrk[_SHMEM_REDUCE_MIN_WRKDATA_SIZE];
+    static int  mine, all;
+    mine = ok ? 1 : 0;
+    shmem_int_min_to_all(&all, &mine, 1, 0, 0, shmem_n_pes(), pwrk, psync);
+    return all!=0;
+}
+}
+
+/* An array in the symmetric heap that is freed when it goes out of scope.
+ * Construction and destruction are collective over all PEs and synchronize
+ * them, so no PE can access an instance that another has not allocated or
+ * has already freed.  If the allocation fails on any PE, the constructor
+ * throws std::bad_alloc on all of them.  Elements are not constructed or
+ * destroyed. */
+template<typename T>
+class sym_array
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "symmetric memory is accessed with memcpy and RMA, so T must be trivially copyable");
+
+  public:
+    explicit sym_array(size_t n)
+        : ptr_(static_cast<T*>(shmemalign(alignof(T), n*sizeof(T)))), n_(n)
+    {
+        /* a PE that threw alone would leave the others waiting in their
+         * next collective */
+        if (!detail::all_pes(ptr_!=nullptr || n==0)) {
+            if (ptr_!=nullptr) shfree(ptr_);
+            throw std::bad_alloc();
+        }
+    }
+
+    ~sym_array() { reset(); }
+
+    sym_array(const sym_array &) = delete;
+    sym_array & operator=(const sym_array &) = delete;
+
+    sym_array(sym_array && other) noexcept : ptr_(other.ptr_), n_(other.n_)
+    {
+        other.ptr_ = nullptr;
+        other.n_   = 0;
+    }
+
+    sym_array & operator=(sym_array && other)
+    {
+        if (this!=&other) {
+            reset();
+            ptr_ = other.ptr_; other.ptr_ = nullptr;
+            n_   = other.n_;   other.n_   = 0;
+        }
+        return *this;
+    }
+
+    /* collective */
+    void reset()
+    {
+        if (ptr_!=nullptr) {
+            shmem_barrier_all();
+            shfree(ptr_);
+            ptr_ = nullptr;
+            n_   = 0;
+        }
+    }
+
+    T *       data()       { return ptr_; }
+    const T * data() const { return ptr_; }
+    size_t    size() const { return n_; }
+
+    T &       operator[](size_t i)       { return ptr_[i]; }
+    const T & operator[](size_t i) const { return ptr_[i]; }
+
+    T *       begin()       { return ptr_; }
+    T *       end()         { return ptr_+n_; }
+    const T * begin() const { return ptr_; }
+    const T * end()   const { return ptr_+n_; }
+
+  private:
+    T *    ptr_;
+    size_t n_;
+};
+
+/*****************************************************************/
+/* Type traits that map T to the typed C routines */
+
+/* These are only declared for unsupported T, so misuse fails to compile. */
+template<typename T> struct rma;
+template<typename T> struct amo;
+template<typename T> struct swap_traits;
+
+#define OSHMPI_HPP_RMA(NAME, TYPE, MPI_TYPE)                                         \
+    template<> struct rma<TYPE> {                                                    \
+        static void p(TYPE *addr, TYPE v, int pe) { shmem_##NAME##_p(addr, v, pe); } \
+        static TYPE g(const TYPE *addr, int pe)                                      \
+        { return shmem_##NAME##_g(const_cast<TYPE*>(addr), pe); }                    \
+        static void put(TYPE *t, const TYPE *s, size_t n, int pe)                    \
+        { shmem_##NAME##_put(t, s, n, pe); }                                         \
+        static void get(TYPE *t, const TYPE *s, size_t n, int pe)                    \
+        { shmem_##NAME##_get(t, s, n, pe); }                                         \
+    };
+OSHMPI_RMA_TYPES(OSHMPI_HPP_RMA)
+#undef OSHMPI_HPP_RMA
+
+#define OSHMPI_HPP_RMA_COMPLEX(NAME, TYPE)                                           \
+    template<> struct rma<TYPE> {                                                    \
+        static void p(TYPE *addr, TYPE v, int pe) { shmem_##NAME##_put(addr, &v, 1, pe); } \
+        static TYPE g(const TYPE *addr, int pe)                                      \
+        { TYPE v; shmem_##NAME##_get(&v, addr, 1, pe); return v; }                   \
+        static void put(TYPE *t, const TYPE *s, size_t n, int pe)                    \
+        { shmem_##NAME##_put(t, s, n, pe); }                                         \
+        static void get(TYPE *t, const TYPE *s, size_t n, int pe)                    \
+        { shmem_##NAME##_get(t, s, n, pe); }                                         \
+    };
+OSHMPI_HPP_RMA_COMPLEX(complexf, std::complex<float>)
+OSHMPI_HPP_RMA_COMPLEX(complexd, std::complex<double>)
+#undef OSHMPI_HPP_RMA_COMPLEX
+
+#define OSHMPI_HPP_AMO(NAME, TYPE, MPI_TYPE)                                         \
+    template<> struct amo<TYPE> {                                                    \
+        static TYPE fetch_add(TYPE *t, TYPE v, int pe) { return shmem_##NAME##_fadd(t, v, pe); } \
+        static void add(TYPE *t, TYPE v, int pe) { shmem_##NAME##_add(t, v, pe); }   \
+        static TYPE compare_swap(TYPE *t, TYPE c, TYPE v, int pe)                    \
+        { return shmem_##NAME##_cswap(t, c, v, pe); }                                \
+    };
+OSHMPI_AMO_TYPES(OSHMPI_HPP_AMO)
+#undef OSHMPI_HPP_AMO
+
+#define OSHMPI_HPP_SWAP(NAME, TYPE, MPI_TYPE, WORD)                                  \
+    template<> struct swap_traits<TYPE> {                                            \
+        static TYPE swap(TYPE *t, TYPE v, int pe) { return shmem_##NAME##_swap(t, v, pe); } \
+    };
+OSHMPI_SWAP_TYPES(OSHMPI_HPP_SWAP)
+#undef OSHMPI_HPP_SWAP
+
+/*****************************************************************/
+/* RMA and atomics */
+
+template<typename T> inline void put(T *target, const T *source, size_t n, int pe) { rma<T>::put(target, source, n, pe); }
+template<typename T> inline void get(T *target, const T *source, size_t n, int pe) { rma<T>::get(target, source, n, pe); }
+template<typename T> inline void p(T *target, T value, int pe) { rma<T>::p(target, value, pe); }
+template<typename T> inline T    g(const T *source, int pe)    { return rma<T>::g(source, pe); }
+
+template<typename T> inline T    atomic_fetch_add(T *target, T value, int pe) { return amo<T>::fetch_add(target, value, pe); }
+template<typename T> inline void atomic_add(T *target, T value, int pe)       { amo<T>::add(target, value, pe); }
+template<typename T> inline T    atomic_fetch_inc(T *target, int pe)          { return amo<T>::fetch_add(target, T(1), pe); }
+template<typename T> inline T    atomic_compare_swap(T *target, T cond, T value, int pe) { return amo<T>::compare_swap(target, cond, value, pe); }
+template<typename T> inline T    atomic_swap(T *target, T value, int pe)      { return swap_traits<T>::swap(target, value, pe); }
+
+/*****************************************************************/
+/* Reductions */
+
+/* PE_start, logPE_stride and PE_size of an OpenSHMEM 1.2 active set */
+struct active_set
+{
+    int start;
+    int log_stride;
+    int size;
+
+    static active_set world() { active_set a = { 0, 0, shmem_n_pes() }; return a; }
+};
+
+/* reduction operators */
+struct sum {};
+struct prod {};
+struct min {};
+struct max {};
+struct bit_and {};
+struct bit_or {};
+struct bit_xor {};
+
+template<typename Op, typename T> struct reduction;
+
+#define OSHMPI_HPP_REDUCE(OP, SUFFIX, NAME, TYPE)                                    \
+    template<> struct reduction<OP, TYPE> {                                          \
+        static void to_all(TYPE *t, TYPE *s, int n, int start, int logs, int size,   \
+                           TYPE *pWrk, long *pSync)                                  \
+        { shmem_##NAME##SUFFIX(t, s, n, start, logs, size, pWrk, pSync); }           \
+    };
+#define OSHMPI_HPP_BITWISE_TYPES(X, OP, SUFFIX)                                      \
+    X(OP, SUFFIX, short,      short)                                                 \
+    X(OP, SUFFIX, int,        int)                                                   \
+    X(OP, SUFFIX, long,       long)                                                  \
+    X(OP, SUFFIX, longlong,   long long)
+#define OSHMPI_HPP_ORDERED_TYPES(X, OP, SUFFIX)                                      \
+    OSHMPI_HPP_BITWISE_TYPES(X, OP, SUFFIX)                                          \
+    X(OP, SUFFIX, float,      float)                                                 \
+    X(OP, SUFFIX, double,     double)                                                \
+    X(OP, SUFFIX, longdouble, long double)
+#define OSHMPI_HPP_ARITHMETIC_TYPES(X, OP, SUFFIX)                                   \
+    OSHMPI_HPP_ORDERED_TYPES(X, OP, SUFFIX)                                          \
+    X(OP, SUFFIX, complexf,   std::complex<float>)                                   \
+    X(OP, SUFFIX, complexd,   std::complex<double>)
+
+OSHMPI_HPP_BITWISE_TYPES(OSHMPI_HPP_REDUCE,    bit_and, _and_to_all)
+OSHMPI_HPP_BITWISE_TYPES(OSHMPI_HPP_REDUCE,    bit_or,  _or_to_all)
+OSHMPI_HPP_BITWISE_TYPES(OSHMPI_HPP_REDUCE,    bit_xor, _xor_to_all)
+OSHMPI_HPP_ORDERED_TYPES(OSHMPI_HPP_REDUCE,    min,     _min_to_all)
+OSHMPI_HPP_ORDERED_TYPES(OSHMPI_HPP_REDUCE,    max,     _max_to_all)
+OSHMPI_HPP_ARITHMETIC_TYPES(OSHMPI_HPP_REDUCE, sum,     _sum_to_all)
+OSHMPI_HPP_ARITHMETIC_TYPES(OSHMPI_HPP_REDUCE, prod,    _prod_to_all)
+
+#undef OSHMPI_HPP_REDUCE
+#undef OSHMPI_HPP_BITWISE_TYPES
+#undef OSHMPI_HPP_ORDERED_TYPES
+#undef OSHMPI_HPP_ARITHMETIC_TYPES
+
+namespace detail {
+/* Static data is symmetric.  OSHMPI reduces with MPI_Allreduce and never
+ * reads pWrk, so the minimum size is enough. */
+inline long * reduce_psync()
+{
+    static long psync[_SHMEM_REDUCE_SYNC_SIZE] = { _SHMEM_SYNC_VALUE };
+    return psync;
+}
+template<typename T> inline T * reduce_pwrk()
+{
+    static T pwrk[_SHMEM_REDUCE_MIN_WRKDATA_SIZE];
+    return pwrk;
+}
+}
+
+/* Collective over the active set, which defaults to all PEs. */
+template<typename Op, typename T>
+inline void reduce(T *target, const T *source, int nreduce, active_set set = active_set::world())
+{
+    reduction<Op,T>::to_all(target, const_cast<T*>(source), nreduce, set.start, set.log_stride, set.size,
+                            detail::reduce_pwrk<T>(), detail::reduce_psync());
+}
+
+template<typename Op, typename T>
+inline void reduce(sym_array<T> & target, const sym_array<T> & source, active_set set = active_set::world())
+{
+    reduce<Op,T>(target.data(), source.data(), (int)(target.size()<source.size() ? target.size() : source.size()), set);
+}
+
+} // namespace oshmpi
+
+#endif /* OSHMPI_SHMEM_HPP */
@@ -0,0 +1,70 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#include "shmemconf.h"
+
+#ifdef EXTENSION_ARENA
+
+#include "shmemx.h"
+#include "shmem-internals.h"
+
+/* what shmalloc guarantees, from dlmalloc */
+#define OSHMPI_ARENA_ALIGNMENT (2*sizeof(void*))
+/* of the base, and so the largest alignment an allocation can have */
+#define OSHMPI_ARENA_MAX_ALIGNMENT 4096
+
+struct shmemx_arena_s {
+    char * base;
+    size_t size;
+    size_t used;
+};
+
+shmemx_arena_t shmemx_arena_create(size_t size)
+{
+    shmemx_arena_t arena = malloc(sizeof(struct shmemx_arena_s));
+    assert(arena!=NULL);
+
+    /* which also keeps allocations off the cache lines of the rest of the heap */
+    arena->base = shmemalign(OSHMPI_ARENA_MAX_ALIGNMENT, size);
+    arena->size = size;
+    arena->used = 0;
+    if (arena->base==NULL) {
+        free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+void shmemx_arena_destroy(shmemx_arena_t arena)
+{
+    if (arena==NULL) return;
+    shfree(arena->base);
+    free(arena);
+}
+
+void * shmemx_arena_align(shmemx_arena_t arena, size_t alignment, size_t size)
+{
+    /* The offset is aligned, which is symmetric whatever the address of the
+     * heap on each PE, and the address follows because the base is aligned
+     * at least as much. */
+    if ( unlikely(alignment==0 || (alignment & (alignment-1))!=0 || alignment > OSHMPI_ARENA_MAX_ALIGNMENT) ) {
+        return NULL;
+    }
+    size_t offset = (arena->used + alignment - 1) & ~(alignment - 1);
+    if ( unlikely(offset > arena->size || size > arena->size - offset) ) {
+        return NULL;
+    }
+    arena->used = offset + size;
+    return arena->base + offset;
+}
+
+void * shmemx_arena_alloc(shmemx_arena_t arena, size_t size)
+{
+    return shmemx_arena_align(arena, OSHMPI_ARENA_ALIGNMENT, size);
+}
+
+void shmemx_arena_reset(shmemx_arena_t arena)
+{
+    arena->used = 0;
+}
+
+#endif
@@ -34,7 +34,7 @@ void oshmpix_put_strided_2d(MPI_Datatype mpi_type, void *target, const void *sou
     fflush(stdout);
 #endif
 
-    MPI_Win win = (win_id==SHMEM_SHEAP_WINDOW) ? shmem_sheap_win : shmem_etext_win;
+    MPI_Win win = oshmpi_win(win_id);
 #ifdef ENABLE_SMP_OPTIMIZATIONS
     if (0) {
         /* TODO */
@@ -110,7 +110,7 @@ void oshmpix_get_strided_2d(MPI_Datatype mpi_type, void *target, const void *sou
     fflush(stdout);
 #endif
 
-    MPI_Win win = (win_id==SHMEM_SHEAP_WINDOW) ? shmem_sheap_win : shmem_etext_win;
+    MPI_Win win = oshmpi_win(win_id);
 #ifdef ENABLE_SMP_OPTIMIZATIONS
     if (0) {
         /* TODO */
@@ -1,9 +1,12 @@
 /* BSD-2 License.  Written by Jeff Hammond. */
 
+#include "shmemconf.h"
+
 #ifdef EXTENSION_COUNTING_PUT
 
 #include "shmemx.h"
 #include "shmem-internals.h"
+#include "shmem-wait.h"
 
 void shmemx_ct_create(shmemx_ct_t *ct)
 {
@@ -23,10 +26,13 @@ long shmemx_ct_get(shmemx_ct_t ct)
     } else
 #endif
     {
-        shmem_offset_t win_offset = (ptrdiff_t)((intptr_t)ct - (intptr_t)shmem_sheap_base_ptr);
+        enum shmem_window_id_e win_id;
+        shmem_offset_t win_offset;
+        oshmpi_window_offset(ct, shmem_world_rank, &win_id, &win_offset);
+        MPI_Win win = oshmpi_win(win_id);
         long output;
-        MPI_Fetch_and_op(NULL, &output, MPI_LONG, shmem_world_rank, win_offset, MPI_NO_OP, shmem_sheap_win);
-        MPI_Win_flush_local(shmem_world_rank, shmem_sheap_win);
+        MPI_Fetch_and_op(NULL, &output, MPI_LONG, shmem_world_rank, win_offset, MPI_NO_OP, win);
+        MPI_Win_flush_local(shmem_world_rank, win);
         return output;
     }
 }
@@ -39,23 +45,36 @@ void shmemx_ct_set(shmemx_ct_t ct, long value)
     } else
 #endif
     {
-        shmem_offset_t win_offset = (ptrdiff_t)((intptr_t)ct - (intptr_t)shmem_sheap_base_ptr);
-        MPI_Fetch_and_op(&value, NULL, MPI_LONG, shmem_world_rank, win_offset, MPI_REPLACE, shmem_sheap_win);
-        MPI_Win_flush(shmem_world_rank, shmem_sheap_win);
+        enum shmem_window_id_e win_id;
+        shmem_offset_t win_offset;
+        oshmpi_window_offset(ct, shmem_world_rank, &win_id, &win_offset);
+        MPI_Win win = oshmpi_win(win_id);
+        MPI_Accumulate(&value, 1, MPI_LONG, shmem_world_rank, win_offset, 1, MPI_LONG, MPI_REPLACE, win);
+        MPI_Win_flush(shmem_world_rank, win);
     }
     return;
 }
 
+/* The counter is local so we poll memory rather than issuing an MPI call
+ * per iteration.  The windows are synced (a memory barrier in the UNIFIED
+ * model) at the start and whenever the wait moves to a slower phase. */
 void shmemx_ct_wait(shmemx_ct_t ct, long wait_for)
 {
-    while (wait_for != shmemx_ct_get(ct));
+    oshmpi_wait_t w;
+    oshmpi_wait_begin(&w);
+    oshmpi_local_sync();
+    while (wait_for != *(volatile long*)ct) {
+        if (oshmpi_wait_backoff(&w))
+            oshmpi_local_sync();
+        oshmpi_etext_poll();
+    }
+    oshmpi_wait_end(&w);
 }
 
 void shmemx_putmem_ct(shmemx_ct_t ct, void *target, const void *source, size_t len, int pe)
 {
-    shmem_putmem(target, source, len, pe);
-    oshmpi_remote_sync_pe(pe);
-    shmem_long_add(ct, 1, pe);
+    long one = 1;
+    oshmpi_put_notify(target, source, len, MPI_LONG, ct, &one, MPI_SUM, pe);
 }
 
 #endif
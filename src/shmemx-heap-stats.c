@@ -0,0 +1,26 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#include "shmemconf.h"
+
+#ifdef EXTENSION_HEAP_STATS
+
+#include "shmemx.h"
+#include "shmem-internals.h"
+#include "oshmpi-sheap-cache.h"
+
+void shmemx_heap_stats(shmemx_heap_stats_t * stats)
+{
+    oshmpi_sheap_stats_t s;
+    oshmpi_sheap_stats(&s);
+
+    stats->size          = s.size;
+    stats->in_use        = s.in_use;
+    stats->cached        = s.cached;
+    stats->free          = s.free;
+    stats->largest_free  = s.largest_free;
+    stats->fragmentation = (s.free>0) ? 1.0 - (double)s.largest_free/s.free : 0.0;
+    stats->high_water    = s.high_water;
+    stats->segments      = s.segments;
+}
+
+#endif
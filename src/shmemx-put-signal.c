@@ -0,0 +1,40 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#include "shmemconf.h"
+
+#ifdef EXTENSION_PUT_SIGNAL
+
+#include "shmemx.h"
+#include "shmem-internals.h"
+#include "shmem-wait.h"
+
+void shmemx_putmem_signal(void *dest, const void *source, size_t len,
+                          uint64_t *sig_addr, uint64_t signal, int sig_op, int pe)
+{
+    MPI_Op op = MPI_OP_NULL;
+    switch (sig_op) {
+        case SHMEMX_SIGNAL_SET: op = MPI_REPLACE; break;
+        case SHMEMX_SIGNAL_ADD: op = MPI_SUM;     break;
+        default: oshmpi_abort(sig_op, "shmemx_putmem_signal: invalid signal operation");
+    }
+    oshmpi_put_notify(dest, source, len, MPI_UINT64_T, sig_addr, &signal, op, pe);
+}
+
+uint64_t shmemx_signal_wait_until(uint64_t *sig_addr, int cmp, uint64_t cmp_value)
+{
+    int cmpret = 0;
+    uint64_t value;
+    oshmpi_wait_t w;
+    oshmpi_wait_begin(&w);
+    oshmpi_local_sync();
+    while (1) {
+        value = *(volatile uint64_t*)sig_addr;
+        COMP(cmp, value, cmp_value, cmpret);
+        if (cmpret) break;
+        oshmpi_wait_poll(&w);
+    }
+    oshmpi_wait_end(&w);
+    return value;
+}
+
+#endif
@@ -0,0 +1,85 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#include "shmemconf.h"
+
+#ifdef EXTENSION_SPACE
+
+#include "shmemx.h"
+#include "shmem-internals.h"
+#include "oshmpi-sheap.h"
+#include "oshmpi-sheap-cache.h"
+
+struct shmemx_space_s {
+    char * base; /* identifies the segment, whose index may change */
+};
+
+static oshmpi_segment_t * oshmpi_space_segment(shmemx_space_t space)
+{
+    shmem_offset_t offset;
+    int i = oshmpi_segment_find(space->base, &offset);
+    assert(i>=0);
+    return &oshmpi_segments[i];
+}
+
+shmemx_space_t shmemx_space_create(size_t size, int hints)
+{
+    /* ATOMICS_ONLY turns puts into MPI_REPLACE and gets into MPI_NO_OP, so
+     * the AMOs would no longer be the same op */
+    if ((hints & SHMEMX_SPACE_SAME_OP) && (hints & SHMEMX_SPACE_ATOMICS_ONLY)) {
+        oshmpi_abort(hints, "shmemx_space_create: SHMEMX_SPACE_SAME_OP cannot be combined with SHMEMX_SPACE_ATOMICS_ONLY");
+    }
+
+    MPI_Info info;
+    MPI_Info_create(&info);
+    if (hints & SHMEMX_SPACE_UNORDERED) {
+        MPI_Info_set(info, "accumulate_ordering", "none");
+    }
+    if (hints & SHMEMX_SPACE_SAME_OP) {
+        MPI_Info_set(info, "accumulate_ops", "same_op_no_op");
+    }
+
+    int flags = OSHMPI_SEGMENT_SPACE;
+    if (hints & SHMEMX_SPACE_ATOMICS_ONLY) flags |= OSHMPI_SEGMENT_ATOMIC_RMA;
+    if (hints & SHMEMX_SPACE_HUGEPAGES)    flags |= OSHMPI_SEGMENT_HUGEPAGES;
+
+    /* room for dlmalloc's bookkeeping */
+    oshmpi_sheap_lock();
+    int i = oshmpi_sheap_segment_create(size + 4096, info, flags);
+    oshmpi_sheap_unlock();
+    MPI_Info_free(&info);
+    if (i<0) {
+        return NULL;
+    }
+
+    shmemx_space_t space = malloc(sizeof(struct shmemx_space_s));
+    assert(space!=NULL);
+    space->base = oshmpi_segments[i].base;
+    return space;
+}
+
+void shmemx_space_destroy(shmemx_space_t space)
+{
+    if (space==NULL) return;
+
+    shmem_offset_t offset;
+    oshmpi_sheap_lock();
+    oshmpi_sheap_segment_destroy(oshmpi_segment_find(space->base, &offset));
+    oshmpi_sheap_unlock();
+    free(space);
+}
+
+void * shmemx_space_align(shmemx_space_t space, size_t alignment, size_t size)
+{
+    oshmpi_sheap_lock();
+    mspace msp = oshmpi_space_segment(space)->msp;
+    void * ptr = (alignment>0) ? mspace_memalign(msp, alignment, size) : mspace_malloc(msp, size);
+    oshmpi_sheap_unlock();
+    return ptr;
+}
+
+void * shmemx_space_malloc(shmemx_space_t space, size_t size)
+{
+    return shmemx_space_align(space, 0, size);
+}
+
+#endif
@@ -0,0 +1,123 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#include "shmemconf.h"
+
+#ifdef EXTENSION_SYM_HANDLE
+
+#include "shmemx.h"
+#include "shmem-internals.h"
+#include "oshmpi-wait.h"
+#include "oshmpi-copy.h"
+
+shmemx_sym_handle_t shmemx_resolve(const void *addr)
+{
+    enum shmem_window_id_e win_id;
+    shmem_offset_t win_offset;
+    shmemx_sym_handle_t h;
+
+    if (oshmpi_window_offset(addr, shmem_world_rank, &win_id, &win_offset)) {
+        oshmpi_abort(shmem_world_rank, "shmemx_resolve: address is not symmetric");
+    }
+
+    h.win      = oshmpi_win(win_id);
+    h.disp     = (MPI_Aint)win_offset;
+    h.smp_ptrs = NULL;
+    h.addr     = (void*)addr;
+    h.atomic   = oshmpi_win_atomic_rma(win_id);
+#ifdef ENABLE_SMP_OPTIMIZATIONS
+    if (shmem_world_is_smp && win_id==SHMEM_SHEAP_WINDOW) {
+        h.smp_ptrs = shmem_smp_sheap_ptrs;
+    } else if (shmem_world_is_smp && win_id>=SHMEM_SEGMENT_WINDOW) {
+        h.smp_ptrs = oshmpi_segments[win_id-SHMEM_SEGMENT_WINDOW].smp_ptrs;
+    }
+#endif
+    return h;
+}
+
+#define SHMEMX_H_PTR(h, offset, pe) ((void*)( (intptr_t)(h).smp_ptrs[pe] + (h).disp + (offset) ))
+
+void shmemx_put_h(shmemx_sym_handle_t h, size_t offset, const void *source, size_t len, int pe)
+{
+    if (h.smp_ptrs!=NULL) {
+        oshmpi_copy(SHMEMX_H_PTR(h, offset, pe), source, len);
+        oshmpi_wait_wake(pe);
+    } else if ( unlikely(len>(size_t)INT32_MAX) ) {
+        oshmpi_put(MPI_BYTE, (char*)h.addr + offset, source, len, pe);
+    } else {
+        if (h.atomic) {
+            MPI_Accumulate(source, (int)len, MPI_BYTE, pe, h.disp + (MPI_Aint)offset, (int)len, MPI_BYTE, MPI_REPLACE, h.win);
+        } else {
+            MPI_Put(source, (int)len, MPI_BYTE, pe, h.disp + (MPI_Aint)offset, (int)len, MPI_BYTE, h.win);
+        }
+        MPI_Win_flush_local(pe, h.win);
+    }
+}
+
+void shmemx_get_h(void *target, shmemx_sym_handle_t h, size_t offset, size_t len, int pe)
+{
+    if (h.smp_ptrs!=NULL) {
+        oshmpi_copy(target, SHMEMX_H_PTR(h, offset, pe), len);
+    } else if ( unlikely(len>(size_t)INT32_MAX) ) {
+        oshmpi_get(MPI_BYTE, target, (char*)h.addr + offset, len, pe);
+    } else {
+        if (h.atomic) {
+            MPI_Get_accumulate(NULL, 0, MPI_DATATYPE_NULL, target, (int)len, MPI_BYTE,
+                               pe, h.disp + (MPI_Aint)offset, (int)len, MPI_BYTE, MPI_NO_OP, h.win);
+        } else {
+            MPI_Get(target, (int)len, MPI_BYTE, pe, h.disp + (MPI_Aint)offset, (int)len, MPI_BYTE, h.win);
+        }
+        MPI_Win_flush_local(pe, h.win);
+    }
+}
+
+long shmemx_long_atomic_fadd_h(shmemx_sym_handle_t h, size_t offset, long value, int pe)
+{
+    long output;
+    if (h.smp_ptrs!=NULL) {
+        output = __sync_fetch_and_add((long*)SHMEMX_H_PTR(h, offset, pe), value);
+        oshmpi_wait_wake(pe);
+    } else {
+        MPI_Fetch_and_op(&value, &output, MPI_LONG, pe, h.disp + (MPI_Aint)offset, MPI_SUM, h.win);
+        MPI_Win_flush(pe, h.win);
+    }
+    return output;
+}
+
+void shmemx_long_atomic_add_h(shmemx_sym_handle_t h, size_t offset, long value, int pe)
+{
+    if (h.smp_ptrs!=NULL) {
+        __sync_fetch_and_add((long*)SHMEMX_H_PTR(h, offset, pe), value);
+        oshmpi_wait_wake(pe);
+    } else {
+        MPI_Accumulate(&value, 1, MPI_LONG, pe, h.disp + (MPI_Aint)offset, 1, MPI_LONG, MPI_SUM, h.win);
+        MPI_Win_flush_local(pe, h.win);
+    }
+}
+
+long shmemx_long_atomic_swap_h(shmemx_sym_handle_t h, size_t offset, long value, int pe)
+{
+    long output;
+    if (h.smp_ptrs!=NULL) {
+        output = __sync_lock_test_and_set((long*)SHMEMX_H_PTR(h, offset, pe), value);
+        oshmpi_wait_wake(pe);
+    } else {
+        MPI_Fetch_and_op(&value, &output, MPI_LONG, pe, h.disp + (MPI_Aint)offset, MPI_REPLACE, h.win);
+        MPI_Win_flush(pe, h.win);
+    }
+    return output;
+}
+
+long shmemx_long_atomic_cswap_h(shmemx_sym_handle_t h, size_t offset, long cond, long value, int pe)
+{
+    long output;
+    if (h.smp_ptrs!=NULL) {
+        output = __sync_val_compare_and_swap((long*)SHMEMX_H_PTR(h, offset, pe), cond, value);
+        oshmpi_wait_wake(pe);
+    } else {
+        MPI_Compare_and_swap(&value, &cond, &output, MPI_LONG, pe, h.disp + (MPI_Aint)offset, h.win);
+        MPI_Win_flush(pe, h.win);
+    }
+    return output;
+}
+
+#endif
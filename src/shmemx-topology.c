@@ -0,0 +1,24 @@
+/* BSD-2 License.  Written by Jeff Hammond. */
+
+#include "shmemconf.h"
+
+#ifdef EXTENSION_TOPOLOGY
+
+#include "shmemx.h"
+#include "shmem-internals.h"
+#include "oshmpi-topo.h"
+
+int shmemx_num_numa_domains(void)
+{
+    return oshmpi_topo_num_numa;
+}
+
+int shmemx_pe_numa_domain(int pe)
+{
+    if (pe<0 || pe>=shmem_world_size || oshmpi_topo_pe_numa==NULL) {
+        return -1;
+    }
+    return oshmpi_topo_pe_numa[pe];
+}
+
+#endif
@@ -10,6 +10,15 @@
 double shmem_wtime(void);
 char* shmem_nodename(void);
 
+/* Global and static variables declared with SHMEMX_SYMMETRIC are placed in
+ * a section of their own.  With OSHMPI_ETEXT_WINDOW=section, only that
+ * section is registered for remote access, rather than all of data and bss. */
+#if defined(__ELF__)
+#define SHMEMX_SYMMETRIC __attribute__((section("oshmpi_symmetric"), used))
+#else
+#define SHMEMX_SYMMETRIC
+#endif
+
 #if EXTENSION_FINAL_ABORT
 #error TODO
 #endif
@@ -79,4 +88,117 @@ void shmemx_aget(void *target, const void *source,
 #error TODO
 #endif
 
+#if EXTENSION_PUT_SIGNAL
+#define SHMEMX_SIGNAL_SET 0
+#define SHMEMX_SIGNAL_ADD 1
+
+/* P2P Communication */
+/* the update of sig_addr is not visible at pe before the payload is */
+void shmemx_putmem_signal(void *dest, const void *source, size_t len,
+                          uint64_t *sig_addr, uint64_t signal, int sig_op, int pe);
+
+/* Local */
+uint64_t shmemx_signal_wait_until(uint64_t *sig_addr, int cmp, uint64_t cmp_value);
+#endif
+
+#if EXTENSION_SYM_HANDLE
+/* The result of looking up a symmetric object once, so that repeated
+ * access to it skips the window search.  Offsets are in bytes. */
+typedef struct {
+    MPI_Win  win;
+    MPI_Aint disp;     /* of the object in win */
+    void **  smp_ptrs; /* base of win at each PE if load-store is possible, else NULL */
+    void *   addr;     /* local address of the object */
+    int      atomic;   /* puts and gets must be accumulates (SHMEMX_SPACE_ATOMICS_ONLY) */
+} shmemx_sym_handle_t;
+
+/* Local */
+shmemx_sym_handle_t shmemx_resolve(const void *addr);
+
+/* P2P Communication */
+void shmemx_put_h(shmemx_sym_handle_t h, size_t offset, const void *source, size_t len, int pe);
+void shmemx_get_h(void *target, shmemx_sym_handle_t h, size_t offset, size_t len, int pe);
+
+long shmemx_long_atomic_fadd_h(shmemx_sym_handle_t h, size_t offset, long value, int pe);
+void shmemx_long_atomic_add_h(shmemx_sym_handle_t h, size_t offset, long value, int pe);
+long shmemx_long_atomic_swap_h(shmemx_sym_handle_t h, size_t offset, long value, int pe);
+long shmemx_long_atomic_cswap_h(shmemx_sym_handle_t h, size_t offset, long cond, long value, int pe);
+#endif
+
+#if EXTENSION_TOPOLOGY
+/* Local */
+/* number of NUMA domains on this node */
+int shmemx_num_numa_domains(void);
+/* NUMA domain of pe, or -1 if pe is on another node or it is not known */
+int shmemx_pe_numa_domain(int pe);
+#endif
+
+#if EXTENSION_ARENA
+/* A block of the symmetric heap that is allocated from by bumping an
+ * offset and freed all at once.  Every PE must make the same sequence of
+ * calls on an arena, as for shmalloc, and then the results are symmetric. */
+typedef struct shmemx_arena_s * shmemx_arena_t;
+
+/* Symmetric Heap */
+/* returns NULL if the heap has no room for size bytes */
+shmemx_arena_t shmemx_arena_create(size_t size);
+void shmemx_arena_destroy(shmemx_arena_t arena);
+
+/* Local */
+/* aligned like shmalloc, or NULL if the arena is full */
+void * shmemx_arena_alloc(shmemx_arena_t arena, size_t size);
+/* alignment is a power of two of at most 4096, or the result is NULL */
+void * shmemx_arena_align(shmemx_arena_t arena, size_t alignment, size_t size);
+/* Frees everything allocated from the arena.  It does not synchronize, so
+ * a barrier is needed first if other PEs may still access the memory. */
+void shmemx_arena_reset(shmemx_arena_t arena);
+#endif
+
+#if EXTENSION_SPACE
+/* A separate symmetric heap with its own window, so that MPI can be told
+ * how the data in it is accessed.  Memory from a space is used with the
+ * usual routines and freed with shfree. */
+typedef struct shmemx_space_s * shmemx_space_t;
+
+/* hints, which may be combined */
+#define SHMEMX_SPACE_DEFAULT      0
+/* AMOs need not be ordered with each other (accumulate_ordering=none) */
+#define SHMEMX_SPACE_UNORDERED    1
+/* only one kind of AMO is used, e.g. only add and fadd, plus fetch
+ * (accumulate_ops=same_op_no_op).  The payload of shmemx_putmem_signal is
+ * written with set, so only SHMEMX_SIGNAL_SET may target such a space. */
+#define SHMEMX_SPACE_SAME_OP      2
+/* puts and gets are done as MPI accumulates, so that they are atomic with
+ * respect to the AMOs on the same data.  Not with SHMEMX_SPACE_SAME_OP. */
+#define SHMEMX_SPACE_ATOMICS_ONLY 4
+/* back the space with transparent huge pages if the kernel allows */
+#define SHMEMX_SPACE_HUGEPAGES    8
+
+/* Symmetric Heap */
+/* returns NULL if no more spaces can be created */
+shmemx_space_t shmemx_space_create(size_t size, int hints);
+void shmemx_space_destroy(shmemx_space_t space);
+/* NULL if the space is full */
+void * shmemx_space_malloc(shmemx_space_t space, size_t size);
+void * shmemx_space_align(shmemx_space_t space, size_t alignment, size_t size);
+#endif
+
+#if EXTENSION_HEAP_STATS
+/* Usage of the symmetric heap at this PE, in bytes.  Spaces are not
+ * included. */
+typedef struct {
+    size_t size;          /* including segments added by OSHMPI_SHEAP_GROWABLE */
+    size_t in_use;        /* in allocated blocks, including ones cached for reuse */
+    size_t cached;        /* of in_use, in the calling thread's allocation cache */
+    size_t free;
+    size_t largest_free;  /* about the largest block that fits without growing */
+    double fragmentation; /* 1 - largest_free/free */
+    size_t high_water;    /* the most in_use has been */
+    int    segments;      /* added by OSHMPI_SHEAP_GROWABLE */
+} shmemx_heap_stats_t;
+
+/* Local */
+void shmemx_heap_stats(shmemx_heap_stats_t * stats);
+#endif
+
 #endif /* OSHMPI_SHMEMX_H */
@@ -13,6 +13,31 @@ check_PROGRAMS += tests/barrier_performance \
                   tests/test_start \
                   tests/test_atomics \
                   tests/test_swap_cswap \
+                  tests/test_counting_put \
+                  tests/test_put_signal \
+                  tests/test_wait_vector \
+                  tests/test_wait_policy \
+                  tests/test_sym_handle \
+                  tests/test_inline \
+                  tests/test_typed_rma \
+                  tests/test_cxx \
+                  tests/test_eager_put \
+                  tests/test_rma_chunk \
+                  tests/test_copy \
+                  tests/test_sheap_hugepages \
+                  tests/test_topology \
+                  tests/test_sheap_noreserve \
+                  tests/test_sheap_grow \
+                  tests/test_sheap_cache \
+                  tests/test_arena \
+                  tests/test_space \
+                  tests/test_heap_stats \
+                  tests/test_sheap_large \
+                  tests/test_etext_lazy \
+                  tests/test_etext_section \
+                  tests/test_etext_cma \
+                  tests/init_performance \
+                  tests/test_put_signal_etext \
                   # end
 
 TESTS += tests/barrier_performance \
@@ -25,6 +50,31 @@ TESTS += tests/barrier_performance \
          tests/test_sheap \
          tests/test_atomics \
 	 tests/test_swap_cswap \
+         tests/test_counting_put \
+         tests/test_put_signal \
+         tests/test_wait_vector \
+         tests/test_wait_policy \
+         tests/test_sym_handle \
+         tests/test_inline \
+         tests/test_typed_rma \
+         tests/test_cxx \
+         tests/test_eager_put \
+         tests/test_rma_chunk \
+         tests/test_copy \
+         tests/test_sheap_hugepages \
+         tests/test_topology \
+         tests/test_sheap_noreserve \
+         tests/test_sheap_grow \
+         tests/test_sheap_cache \
+         tests/test_arena \
+         tests/test_space \
+         tests/test_heap_stats \
+         tests/test_sheap_large \
+         tests/test_etext_lazy \
+         tests/test_etext_section \
+         tests/test_etext_cma \
+         tests/init_performance \
+         tests/test_put_signal_etext \
          # end
 
 tests_barrier_performance_LDADD = libshmem.la
@@ -38,3 +88,29 @@ tests_test_sheap_LDADD = libshmem.la
 tests_test_start_LDADD = libshmem.la
 tests_test_atomics_LDADD = libshmem.la
 tests_test_swap_cswap_LDADD = libshmem.la
+tests_test_counting_put_LDADD = libshmem.la
+tests_test_put_signal_LDADD = libshmem.la
+tests_test_wait_vector_LDADD = libshmem.la
+tests_test_wait_policy_LDADD = libshmem.la
+tests_test_sym_handle_LDADD = libshmem.la
+tests_test_inline_LDADD = libshmem.la
+tests_test_typed_rma_LDADD = libshmem.la
+tests_test_cxx_LDADD = libshmem.la
+tests_test_cxx_SOURCES = tests/test_cxx.cpp
+tests_test_eager_put_LDADD = libshmem.la
+tests_test_rma_chunk_LDADD = libshmem.la
+tests_test_copy_LDADD = libshmem.la
+tests_test_sheap_hugepages_LDADD = libshmem.la
+tests_test_topology_LDADD = libshmem.la
+tests_test_sheap_noreserve_LDADD = libshmem.la
+tests_test_sheap_grow_LDADD = libshmem.la
+tests_test_sheap_cache_LDADD = libshmem.la
+tests_test_arena_LDADD = libshmem.la
+tests_test_space_LDADD = libshmem.la
+tests_test_heap_stats_LDADD = libshmem.la
+tests_test_sheap_large_LDADD = libshmem.la
+tests_test_etext_lazy_LDADD = libshmem.la
+tests_test_etext_section_LDADD = libshmem.la
+tests_test_etext_cma_LDADD = libshmem.la
+tests_init_performance_LDADD = libshmem.la
+tests_test_put_signal_etext_LDADD = libshmem.la
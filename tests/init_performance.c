@@ -0,0 +1,17 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <shmem.h>
+
+/* Startup time.  With OSHMPI_INIT_PROFILE=2 (the default here), PE 0 prints
+ * the time of each phase of initialization, the maximum over PEs, as a CSV
+ * header and row.  tests/init_scaling.sh runs this for a range of PE counts. */
+
+int main(void)
+{
+    setenv("OSHMPI_INIT_PROFILE", "2", 0);
+
+    start_pes(0);
+
+    shmem_barrier_all();
+    return 0;
+}
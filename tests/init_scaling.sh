@@ -0,0 +1,55 @@
+#! /bin/sh
+#
+# Copyright (C) 2014. See LICENSE in top-level directory.
+#
+# Startup time of OSHMPI against the number of PEs, as CSV on stdout.
+#
+#   tests/init_scaling.sh [max PEs] [repetitions]
+#
+# From the build directory, runs tests/init_performance (built by
+# "make checkprogs") on 2, 4, 8, ... PEs up to max PEs, which defaults to
+# twice the number of cores so that the last runs are oversubscribed, and on
+# max PEs itself.  Each count is run
+# repetitions times (default 3), one row per run.  MPIEXEC is the launcher
+# (default mpiexec).
+
+prog=tests/init_performance
+cores=`getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1`
+max=${1:-`expr 2 \* $cores`}
+reps=${2:-3}
+MPIEXEC=${MPIEXEC:-mpiexec}
+
+# Open MPI refuses to run more processes than cores without this.
+OMPI_MCA_rmaps_base_oversubscribe=${OMPI_MCA_rmaps_base_oversubscribe:-1}
+export OMPI_MCA_rmaps_base_oversubscribe
+
+if [ ! -x "$prog" ]; then
+    echo "$0: $prog not found - run make checkprogs first" >&2
+    exit 1
+fi
+
+counts=
+n=2
+while [ $n -lt $max ]; do
+    counts="$counts $n"
+    n=`expr 2 \* $n`
+done
+counts="$counts $max"
+
+header=
+for n in $counts; do
+    r=0
+    while [ $r -lt $reps ]; do
+        out=`OSHMPI_INIT_PROFILE=2 $MPIEXEC -n $n "$prog"`
+        if [ $? -ne 0 ]; then
+            echo "$0: $n PEs failed" >&2
+            exit 1
+        fi
+        if [ -z "$header" ]; then
+            header=`echo "$out" | grep '^npes,'`
+            echo "$header,cores"
+        fi
+        echo "$out" | grep '^[0-9]' | sed "s/\$/,$cores/"
+        r=`expr $r + 1`
+    done
+done
@@ -327,6 +327,8 @@ void link_contended_lbw (unsigned int msg_size /* actual msg size is 2^msg_size
 
         target_rank = (_world_size - _world_rank - 1);
 
+        shmem_barrier_all();
+
         time_start = shmem_wtime();
 
         if (_world_rank != target_rank)
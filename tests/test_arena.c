@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define SIZE   (1<<20)
+#define NSTEPS 10
+#define NTEMPS 20
+
+int main(void)
+{
+#if EXTENSION_ARENA
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    shmemx_arena_t arena = shmemx_arena_create(SIZE);
+    shmemx_arena_t other = shmemx_arena_create(SIZE);
+    assert(arena!=NULL && other!=NULL);
+
+    /* Timesteps that allocate temporaries and reset the arena at the end.
+     * Each temporary follows the previous one, aligned as asked, and lands
+     * in the same place every step. */
+    long * first[NTEMPS];
+    for (int step=0; step<NSTEPS; step++) {
+        long * temps[NTEMPS];
+        char * end = NULL;
+        for (int t=0; t<NTEMPS; t++) {
+            size_t n = 1 + (size_t)(t*37)%500;
+            size_t alignment = (t%3==0) ? 256 : 2*sizeof(void*);
+            temps[t] = (t%3==0) ? shmemx_arena_align(arena, 256, n*sizeof(long))
+                                : shmemx_arena_alloc(arena, n*sizeof(long));
+            assert(temps[t]!=NULL);
+            assert((uintptr_t)temps[t] % alignment == 0);
+            if (end!=NULL) {
+                assert((char*)temps[t] >= end);
+                assert((char*)temps[t] <  end + alignment);
+            }
+            end = (char*)(temps[t] + n);
+            if (step==0) first[t] = temps[t];
+            else assert(temps[t]==first[t]);
+        }
+        for (int t=0; t<NTEMPS; t++)
+            shmem_long_p(temps[t], (long)(1000*step + 10*mype + t), next);
+        shmem_barrier_all();
+        for (int t=0; t<NTEMPS; t++)
+            assert(*temps[t]==(long)(1000*step + 10*prev + t));
+
+        /* no one may write into the arena after it is reset */
+        shmem_barrier_all();
+        shmemx_arena_reset(arena);
+    }
+
+    /* resetting one arena leaves the other alone */
+    long * kept = shmemx_arena_alloc(other, sizeof(long));
+    assert(kept!=NULL);
+    *kept = mype;
+    shmemx_arena_reset(arena);
+    void * p = shmemx_arena_alloc(other, sizeof(long));
+    assert((char*)p==(char*)kept + 2*sizeof(void*));
+    assert(*kept==mype);
+    shmemx_arena_reset(other);
+
+    /* it is full when it is full */
+    p = shmemx_arena_alloc(arena, SIZE+1);
+    assert(p==NULL);
+    p = shmemx_arena_alloc(arena, SIZE);
+    assert(p!=NULL);
+    p = shmemx_arena_alloc(arena, 1);
+    assert(p==NULL);
+    shmemx_arena_reset(arena);
+
+    /* the alignment is a power of two, at most what the base is aligned to */
+    p = shmemx_arena_align(arena, 8192, 1);
+    assert(p==NULL);
+    p = shmemx_arena_align(arena, 4096, 1);
+    assert(p!=NULL && (uintptr_t)p % 4096 == 0);
+    p = shmemx_arena_align(arena, 3, 1);
+    assert(p==NULL);
+    p = shmemx_arena_align(arena, 0, 1);
+    assert(p==NULL);
+
+    shmem_barrier_all();
+
+    shmemx_arena_destroy(other);
+    shmemx_arena_destroy(arena);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+#else
+    printf("arena extension is not enabled\n");
+    return 77;
+#endif
+}
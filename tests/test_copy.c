@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <shmem.h>
+
+#define NBYTES (1<<20)
+#define PAD    64
+
+static const size_t sizes[]   = { 7, 999, 1000, 4097, 99999, 100000, 100001, 333333, NBYTES };
+static const size_t offsets[] = { 0, 1, 13, 63 };
+
+static unsigned char pattern(int pe, size_t i, size_t s)
+{
+    return (unsigned char)(pe + i*7 + s);
+}
+
+int main(void)
+{
+    /* Small thresholds, so that the sizes below go through memcpy, the
+     * non-temporal path and the helper threads, each split unevenly.
+     * They are read in start_pes, so they have to be set before. */
+    setenv("OSHMPI_COPY_NT_THRESHOLD", "1000", 1);
+    setenv("OSHMPI_COPY_THREADS", "3", 1);
+    setenv("OSHMPI_COPY_THREAD_THRESHOLD", "100000", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    unsigned char * heap = shmalloc(NBYTES+2*PAD);
+    unsigned char * src  = malloc(NBYTES+2*PAD);
+    unsigned char * dst  = malloc(NBYTES+2*PAD);
+
+    for (size_t s=0; s<sizeof(sizes)/sizeof(sizes[0]); s++) {
+        for (size_t o=0; o<sizeof(offsets)/sizeof(offsets[0]); o++) {
+            const size_t n = sizes[s];
+            /* the source is misaligned by a different amount than the target */
+            const size_t toff = PAD+offsets[o], soff = PAD+63-offsets[o];
+
+            memset(heap, 0xff, NBYTES+2*PAD);
+            memset(dst,  0xff, NBYTES+2*PAD);
+            for (size_t i=0; i<n; i++)
+                src[soff+i] = pattern(mype, i, s);
+            shmem_barrier_all();
+
+            shmem_putmem(heap+toff, src+soff, n, next);
+            shmem_barrier_all();
+
+            /* the unaligned head and tail are written, and nothing around them */
+            assert(heap[toff-1]==0xff);
+            for (size_t i=0; i<n; i++)
+                assert(heap[toff+i]==pattern(prev, i, s));
+            assert(heap[toff+n]==0xff);
+
+            shmem_getmem(dst+soff, heap+toff, n, next);
+            assert(dst[soff-1]==0xff);
+            assert(memcmp(dst+soff, src+soff, n)==0);
+            assert(dst[soff+n]==0xff);
+            shmem_barrier_all();
+        }
+    }
+
+    free(dst);
+    free(src);
+    shfree(heap);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
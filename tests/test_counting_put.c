@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define NITER 100
+#define NELEM 1024
+
+int main(void)
+{
+#if EXTENSION_COUNTING_PUT
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    long * buf = shmalloc(NITER*NELEM*sizeof(long));
+    long * src = malloc(NELEM*sizeof(long));
+
+    shmemx_ct_t ct;
+    shmemx_ct_create(&ct);
+    shmemx_ct_set(ct, 0);
+
+    memset(buf, 0, NITER*NELEM*sizeof(long));
+
+    shmem_barrier_all();
+
+    for (int i=0; i<NITER; i++) {
+        for (int j=0; j<NELEM; j++)
+            src[j] = mype*NITER*NELEM + i*NELEM + j;
+        shmemx_putmem_ct(ct, &buf[i*NELEM], src, NELEM*sizeof(long), next);
+    }
+
+    /* the counter is incremented only after the corresponding data has arrived */
+    shmemx_ct_wait(ct, NITER);
+    for (int i=0; i<NITER; i++) {
+        for (int j=0; j<NELEM; j++)
+            assert(buf[i*NELEM+j] == prev*NITER*NELEM + i*NELEM + j);
+    }
+    assert(shmemx_ct_get(ct)==NITER);
+
+    shmem_barrier_all();
+
+    shmemx_ct_free(&ct);
+    free(src);
+    shfree(buf);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+#else
+    printf("counting put extension is not enabled\n");
+    return 77;
+#endif
+}
@@ -0,0 +1,117 @@
+#include <cstdio>
+#include <cassert>
+#include <complex>
+#include <shmem.hpp>
+
+#define NELEM 100
+
+long global_counter = 0;
+
+template<typename T>
+static void ring_put_get(int mype, int next, int prev)
+{
+    oshmpi::sym_array<T> a(NELEM);
+    for (size_t i=0; i<a.size(); i++) a[i] = T(0);
+
+    T src[NELEM];
+    for (int i=0; i<NELEM; i++) src[i] = T(mype*NELEM+i);
+
+    shmem_barrier_all();
+    oshmpi::put(a.data(), src, NELEM, next);
+    shmem_barrier_all();
+
+    for (int i=0; i<NELEM; i++)
+        assert(a[i] == T(prev*NELEM+i));
+
+    T dst[NELEM];
+    oshmpi::get(dst, a.data(), NELEM, next);
+    for (int i=0; i<NELEM; i++)
+        assert(dst[i] == src[i]);
+
+    assert(oshmpi::g(&a[1], next) == src[1]);
+    shmem_barrier_all();
+}
+
+int main(void)
+{
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    ring_put_get<short>(mype, next, prev);
+    ring_put_get<int>(mype, next, prev);
+    ring_put_get<long long>(mype, next, prev);
+    ring_put_get<double>(mype, next, prev);
+    ring_put_get<std::complex<double> >(mype, next, prev);
+
+    {
+        oshmpi::sym_array<long> ctr(1);
+        ctr[0] = 0;
+        shmem_barrier_all();
+
+        for (int i=0; i<NELEM; i++) {
+            oshmpi::atomic_add(ctr.data(), 1L, 0);
+            oshmpi::atomic_fetch_inc(&global_counter, 0);
+        }
+        shmem_barrier_all();
+        if (mype==0) {
+            assert(ctr[0] == (long)npes*NELEM);
+            assert(global_counter == (long)npes*NELEM);
+        }
+        shmem_barrier_all();
+
+        ctr[0] = mype;
+        shmem_barrier_all();
+
+        long old = oshmpi::atomic_swap(ctr.data(), -1L, next);
+        assert(old == next);
+        old = oshmpi::atomic_compare_swap(ctr.data(), -1L, 42L, next);
+        assert(old == -1);
+        old = oshmpi::atomic_fetch_add(ctr.data(), 1L, next);
+        assert(old == 42);
+        oshmpi::p(ctr.data(), 7L, next);
+        assert(oshmpi::g(ctr.data(), next) == 7);
+    }
+
+    {
+        oshmpi::sym_array<int>    is(4), it(4);
+        oshmpi::sym_array<double> ds(4), dt(4);
+        for (int i=0; i<4; i++) {
+            is[i] = mype+i;
+            ds[i] = 0.5*mype;
+        }
+
+        oshmpi::reduce<oshmpi::sum>(it, is);
+        for (int i=0; i<4; i++)
+            assert(it[i] == npes*(npes-1)/2 + npes*i);
+
+        oshmpi::reduce<oshmpi::max>(dt, ds);
+        for (int i=0; i<4; i++)
+            assert(dt[i] == 0.5*(npes-1));
+
+        oshmpi::reduce<oshmpi::bit_or>(it.data(), is.data(), 1);
+        int expect = 0;
+        for (int pe=0; pe<npes; pe++) expect |= pe;
+        assert(it[0] == expect);
+    }
+
+    {
+        /* a failure on one PE is seen on all of them */
+        bool thrown = false;
+        try {
+            oshmpi::sym_array<char> big(mype==0 ? ((size_t)1<<62) : 1);
+        } catch (std::bad_alloc &) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    shmem_barrier_all();
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <shmem.h>
+
+#define NPUTS     1000
+#define NLONG     64 /* 512 bytes, twice the threshold */
+
+/* Global, so that puts go through MPI even between PEs on one node. */
+long dst[NPUTS*NLONG];
+long last;
+
+int main(void)
+{
+    /* A pool of a few slots, so that the ring wraps around many times.
+     * Both are read in start_pes, so they have to be set before. */
+    setenv("OSHMPI_EAGER_THRESHOLD", "256", 1);
+    setenv("OSHMPI_EAGER_POOL_SIZE", "1024", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    memset(dst, 0xff, sizeof(dst));
+    shmem_barrier_all();
+
+    /* Sizes on both sides of the threshold, from one source buffer that
+     * is overwritten as soon as the put returns. */
+    long src[NLONG];
+    for (int i=0; i<NPUTS; i++) {
+        int n = 1 + i%NLONG;
+        for (int j=0; j<NLONG; j++)
+            src[j] = (long)mype*NPUTS*NLONG + i*NLONG + j;
+        shmem_long_put(&dst[i*NLONG], src, (size_t)n, next);
+        memset(src, 0, sizeof(src));
+    }
+    shmem_barrier_all();
+
+    for (int i=0; i<NPUTS; i++) {
+        int n = 1 + i%NLONG;
+        for (int j=0; j<NLONG; j++)
+            assert(dst[i*NLONG+j] == (j<n ? (long)prev*NPUTS*NLONG + i*NLONG + j : -1));
+    }
+
+    /* A fence orders eager puts to the same word, so the last one wins. */
+    for (long i=0; i<NPUTS; i++) {
+        shmem_long_p(&last, i, next);
+        shmem_fence();
+    }
+    shmem_barrier_all();
+    assert(last==NPUTS-1);
+    shmem_barrier_all();
+
+    /* Slots are reused after quiet; the data is still that of the last put. */
+    for (long i=0; i<NPUTS; i++) {
+        src[0] = -i;
+        shmem_long_put(&last, src, 1, next);
+        shmem_quiet();
+    }
+    shmem_barrier_all();
+    assert(last==-(NPUTS-1));
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <shmem.h>
+
+#define SIZE  (1<<18)
+#define SMALL 16
+
+/* in bss, and in data, whose addresses differ between PEs with ASLR */
+static long data[SIZE];
+static long source[SIZE];
+static long result[SIZE];
+static int  small[SMALL] = { 1 };
+long        word = 0;
+long        flag = 0;
+
+int main(void)
+{
+    /* It is read in start_pes, so it has to be set before. */
+    setenv("OSHMPI_ETEXT_CMA", "1", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    for (int i=0; i<SIZE; i++)
+        source[i] = (long)mype*SIZE + i;
+    shmem_barrier_all();
+
+    /* large, small enough for the eager path, and elemental */
+    shmem_long_put(data, source, SIZE, next);
+    shmem_int_put(small, (int*)source, SMALL-1, next);
+    shmem_int_p(&small[SMALL-1], -mype, next);
+    shmem_barrier_all();
+
+    for (int i=0; i<SIZE; i++)
+        assert(data[i]==(long)prev*SIZE + i);
+    for (int i=0; i<SMALL-1; i++)
+        assert(small[i]==((int*)data)[i]);
+    assert(small[SMALL-1]==-prev);
+
+    /* the whole array, and a piece in the middle */
+    shmem_long_get(result, data, SIZE, next);
+    assert(memcmp(result, source, SIZE*sizeof(long))==0);
+    shmem_long_get(result, &data[SIZE/2+1], 3, next);
+    for (int i=0; i<3; i++)
+        assert(result[i]==source[SIZE/2+1+i]);
+    shmem_barrier_all();
+
+    /* Atomics still go through MPI, and a fence orders them after a
+     * put by cross-memory attach to the same word. */
+    long v = 100*mype;
+    shmem_long_put(&word, &v, 1, next);
+    shmem_fence();
+    shmem_long_add(&word, 1, next);
+    shmem_barrier_all();
+    assert(word==100*prev+1);
+    shmem_barrier_all();
+
+    /* a put is complete when it returns, so the flag can follow it */
+    for (int i=0; i<SIZE; i++)
+        source[i] = -source[i];
+    shmem_long_put(data, source, SIZE, next);
+    shmem_fence();
+    shmem_long_p(&flag, 1, next);
+    shmem_long_wait_until(&flag, SHMEM_CMP_EQ, 1);
+    for (int i=0; i<SIZE; i++)
+        assert(data[i]==-((long)prev*SIZE + i));
+
+    shmem_barrier_all();
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
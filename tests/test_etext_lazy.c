@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <shmem.h>
+
+#define SIZE 100
+
+static int  data[SIZE];
+static long flag;
+static long src, dst;
+static long pSync[_SHMEM_REDUCE_SYNC_SIZE];
+static long pWrk[_SHMEM_REDUCE_MIN_WRKDATA_SIZE];
+
+int main(void)
+{
+    /* It is read in start_pes, so it has to be set before. */
+    setenv("OSHMPI_ETEXT_WINDOW", "lazy", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int last = npes-1;
+
+    for (int i=0; i<_SHMEM_REDUCE_SYNC_SIZE; i++)
+        pSync[i] = _SHMEM_SYNC_VALUE;
+
+    /* programs that only use the heap never need the window */
+    long * heap = shmalloc(2*sizeof(long));
+    heap[0] = heap[1] = 0;
+    shmem_barrier_all();
+    shmem_long_add(&heap[0], 1, 0);
+    shmem_barrier_all();
+    if (mype==0) assert(heap[0]==npes);
+
+    /* The last PE is the first to touch static data, while the others
+     * wait on the heap, so they must create the window from inside the
+     * wait before the last PE can set the flag they wait for. */
+    if (mype==last) {
+        for (int i=0; i<SIZE; i++)
+            data[i] = i;
+        for (int pe=0; pe<last; pe++) {
+            shmem_int_put(data, data, SIZE, pe);
+            shmem_fence();
+            shmem_long_p(&heap[1], 1, pe);
+        }
+    } else {
+        shmem_long_wait_until(&heap[1], SHMEM_CMP_EQ, 1);
+    }
+    for (int i=0; i<SIZE; i++)
+        assert(data[i]==i);
+    shmem_barrier_all();
+
+    /* once created, waits and collectives on static data work as usual */
+    if (mype==0) {
+        for (int pe=1; pe<npes; pe++)
+            shmem_long_p(&flag, 1, pe);
+    } else {
+        shmem_long_wait_until(&flag, SHMEM_CMP_EQ, 1);
+    }
+    src = 1+mype;
+    shmem_long_sum_to_all(&dst, &src, 1, 0, 0, npes, pWrk, pSync);
+    assert(dst==(long)npes*(npes+1)/2);
+
+    shmem_barrier_all();
+
+    shfree(heap);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define SIZE 1000
+
+/* zero and nonzero initial values, which would otherwise be in bss and data */
+SHMEMX_SYMMETRIC static int  data[SIZE];
+SHMEMX_SYMMETRIC long        counter = 42;
+static int                   private_data[SIZE];
+int                          private_global = 7;
+
+int main(void)
+{
+#ifdef __linux__
+    /* It is read in start_pes, so it has to be set before. */
+    setenv("OSHMPI_ETEXT_WINDOW", "section", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    /* Only the section is registered, from its first byte to its last. */
+    assert(shmem_addr_accessible(&data[0], next));
+    assert(shmem_addr_accessible(&data[SIZE-1], next));
+    assert(shmem_addr_accessible(&counter, next));
+    assert(!shmem_addr_accessible(private_data, next));
+    assert(!shmem_addr_accessible(&private_global, next));
+
+    /* its initial values are those of the program */
+    assert(counter==42);
+    assert(data[0]==0 && data[SIZE-1]==0);
+
+    for (int i=0; i<SIZE; i++)
+        private_data[i] = mype*SIZE + i;
+    shmem_barrier_all();
+
+    shmem_int_put(data, private_data, SIZE, next);
+    shmem_long_add(&counter, 1, 0);
+    shmem_barrier_all();
+
+    for (int i=0; i<SIZE; i++)
+        assert(data[i]==prev*SIZE + i);
+    if (mype==0) assert(counter==42+npes);
+    assert(shmem_long_g(&counter, 0)==42+npes);
+    assert(private_global==7);
+
+    shmem_barrier_all();
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+#else
+    printf("the symmetric section is only supported on Linux\n");
+    return 77;
+#endif
+}
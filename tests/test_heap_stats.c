@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define BIG (1<<20)
+
+long in_use;
+
+int main(void)
+{
+#if EXTENSION_HEAP_STATS
+    /* Report at finalize, and cache small blocks.  Both are read in
+     * start_pes, so they have to be set before. */
+    setenv("OSHMPI_HEAP_STATS", "1", 1);
+    setenv("OSHMPI_SHEAP_CACHE_MAX", "65536", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    shmemx_heap_stats_t s0, s1, s2, s3;
+
+    shmemx_heap_stats(&s0);
+    assert(s0.size>0);
+    assert(s0.in_use+s0.free<=s0.size);
+    assert(s0.largest_free<=s0.free);
+    assert(s0.high_water>=s0.in_use);
+    assert(s0.segments==0);
+
+    char * a = shmalloc(BIG);
+    char * b = shmalloc(BIG);
+    char * c = shmalloc(BIG);
+    shmemx_heap_stats(&s1);
+    assert(s1.in_use>=s0.in_use+3*BIG);
+    assert(s1.free<=s0.free-3*BIG);
+    assert(s1.high_water>=s1.in_use);
+
+    /* The same allocations on every PE give the same usage. */
+    in_use = (long)s1.in_use;
+    shmem_barrier_all();
+    assert(shmem_long_g(&in_use, (mype+1)%npes)==in_use);
+    shmem_barrier_all();
+
+    /* A hole between a and c is free but not part of the largest block,
+     * and freeing does not lower the high-water mark. */
+    shfree(b);
+    shmemx_heap_stats(&s2);
+    assert(s2.in_use<=s1.in_use-BIG);
+    assert(s2.free>=s1.free+BIG-64); /* less the allocator's bookkeeping */
+    assert(s2.high_water==s1.high_water);
+    assert(s2.fragmentation>s1.fragmentation);
+    assert(s2.fragmentation==1.0-(double)s2.largest_free/s2.free);
+
+    shfree(c);
+    shfree(a);
+    shmemx_heap_stats(&s3);
+    assert(s3.in_use==s0.in_use);
+    assert(s3.high_water>=s0.in_use+3*BIG);
+
+    /* A small block is kept in the allocation cache after shfree, and is
+     * still counted as in use. */
+    long * x = shmalloc(sizeof(long));
+    shmemx_heap_stats(&s1);
+    shfree(x);
+    shmemx_heap_stats(&s2);
+    assert(s2.in_use==s1.in_use);
+    assert(s2.cached>=s1.cached+sizeof(long));
+    assert(s2.cached<=s2.in_use);
+
+    shmem_barrier_all();
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+#else
+    printf("heap stats extension is not enabled\n");
+    return 77;
+#endif
+}
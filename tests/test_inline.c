@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <assert.h>
+
+/* use the header-inline p/g and AMO routines */
+#define OSHMPI_INLINE
+#include <shmem.h>
+
+#define NELEM 1000
+
+long global_counter = 0;
+int  global_int     = 0;
+
+int main(void)
+{
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    long   * buf = shmalloc(NELEM*sizeof(long));
+    double * dbl = shmalloc(NELEM*sizeof(double));
+    long   * ctr = shmalloc(sizeof(long));
+    for (int i=0; i<NELEM; i++) {
+        buf[i] = -1;
+        dbl[i] = -1.0;
+    }
+    *ctr = 0;
+
+    shmem_barrier_all();
+
+    /* elemental put and get on the heap */
+    for (int i=0; i<NELEM; i++) {
+        shmem_long_p(&buf[i], mype*NELEM+i, next);
+        shmem_double_p(&dbl[i], 0.5*i, next);
+    }
+
+    shmem_barrier_all();
+
+    for (int i=0; i<NELEM; i++) {
+        assert(buf[i] == prev*NELEM+i);
+        assert(dbl[i] == 0.5*i);
+        assert(shmem_long_g(&buf[i], next) == mype*NELEM+i);
+    }
+
+    /* atomics on the heap and on global data, which takes the library path */
+    for (int i=0; i<NELEM; i++) {
+        shmem_long_add(ctr, 1, 0);
+        shmem_long_finc(&global_counter, 0);
+    }
+
+    shmem_barrier_all();
+
+    if (mype==0) {
+        assert(*ctr == (long)npes*NELEM);
+        assert(global_counter == (long)npes*NELEM);
+    }
+
+    shmem_barrier_all();
+
+    *ctr = mype;
+    global_int = mype;
+
+    shmem_barrier_all();
+
+    long old = shmem_long_swap(ctr, -1, next);
+    assert(old == next);
+    old = shmem_long_cswap(ctr, -1, 42, next);
+    assert(old == -1);
+    assert(shmem_long_g(ctr, next) == 42);
+
+    int iold = shmem_int_fadd(&global_int, 10, next);
+    assert(iold == next);
+    shmem_int_inc(&global_int, next);
+    assert(shmem_int_g(&global_int, next) == next+11);
+
+    shmem_barrier_all();
+
+    shfree(ctr);
+    shfree(dbl);
+    shfree(buf);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
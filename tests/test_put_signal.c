@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define NITER 100
+#define NELEM 1024
+
+int main(void)
+{
+#if EXTENSION_PUT_SIGNAL
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    long     * buf = shmalloc(NITER*NELEM*sizeof(long));
+    uint64_t * sig = shmalloc(2*sizeof(uint64_t));
+    long     * src = malloc(NELEM*sizeof(long));
+
+    memset(buf, 0, NITER*NELEM*sizeof(long));
+    sig[0] = 0;
+    sig[1] = 0;
+
+    shmem_barrier_all();
+
+    /* SHMEMX_SIGNAL_ADD: the count is complete only after all payloads arrive */
+    for (int i=0; i<NITER; i++) {
+        for (int j=0; j<NELEM; j++)
+            src[j] = mype*NITER*NELEM + i*NELEM + j;
+        shmemx_putmem_signal(&buf[i*NELEM], src, NELEM*sizeof(long), &sig[0], 1, SHMEMX_SIGNAL_ADD, next);
+    }
+
+    uint64_t v = shmemx_signal_wait_until(&sig[0], SHMEM_CMP_EQ, NITER);
+    assert(v==NITER);
+    for (int i=0; i<NITER; i++)
+        for (int j=0; j<NELEM; j++)
+            assert(buf[i*NELEM+j] == prev*NITER*NELEM + i*NELEM + j);
+
+    shmem_barrier_all();
+
+    /* SHMEMX_SIGNAL_SET */
+    for (int j=0; j<NELEM; j++)
+        src[j] = -mype-j;
+    shmemx_putmem_signal(buf, src, NELEM*sizeof(long), &sig[1], 1+mype, SHMEMX_SIGNAL_SET, next);
+
+    v = shmemx_signal_wait_until(&sig[1], SHMEM_CMP_NE, 0);
+    assert(v==1+prev);
+    for (int j=0; j<NELEM; j++)
+        assert(buf[j] == -prev-j);
+
+    shmem_barrier_all();
+
+    free(src);
+    shfree(sig);
+    shfree(buf);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+#else
+    printf("put signal extension is not enabled\n");
+    return 77;
+#endif
+}
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define NITER 100
+#define NELEM 1024
+
+/* Static data is not in the shared-memory path even on one node, so a
+ * payload or signal here goes through MPI, and the signal must not
+ * overtake the payload. */
+static long     buf[NITER*NELEM];
+static long     src[NELEM];
+static uint64_t sig = 0;
+
+int main(void)
+{
+#if EXTENSION_PUT_SIGNAL
+    /* Keep static data out of cross-memory attach.  It is read in
+     * start_pes, so it has to be set before. */
+    setenv("OSHMPI_ETEXT_CMA", "0", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    uint64_t * heap_sig = shmalloc(sizeof(uint64_t));
+    long     * heap_buf = shmalloc(NELEM*sizeof(long));
+    *heap_sig = 0;
+    shmem_barrier_all();
+
+    /* static payload, static signal, one at a time */
+    for (int i=0; i<NITER; i++) {
+        for (int j=0; j<NELEM; j++)
+            src[j] = mype*NITER + i + j;
+        shmemx_putmem_signal(buf, src, NELEM*sizeof(long), &sig, i+1, SHMEMX_SIGNAL_SET, next);
+
+        uint64_t v = shmemx_signal_wait_until(&sig, SHMEM_CMP_EQ, i+1);
+        assert(v==(uint64_t)i+1);
+        for (int j=0; j<NELEM; j++)
+            assert(buf[j]==prev*NITER + i + j);
+
+        /* nobody overwrites buf before its owner has checked it */
+        shmem_barrier_all();
+    }
+
+    /* static payloads counted by a signal in the heap, all in flight */
+    for (int i=0; i<NITER; i++) {
+        for (int j=0; j<NELEM; j++)
+            src[j] = -(mype*NITER + i + j);
+        shmemx_putmem_signal(&buf[i*NELEM], src, NELEM*sizeof(long), heap_sig, 1, SHMEMX_SIGNAL_ADD, next);
+    }
+    shmemx_signal_wait_until(heap_sig, SHMEM_CMP_EQ, NITER);
+    for (int i=0; i<NITER; i++)
+        for (int j=0; j<NELEM; j++)
+            assert(buf[i*NELEM+j]==-(prev*NITER + i + j));
+    shmem_barrier_all();
+
+    /* a heap payload behind a static signal */
+    for (int j=0; j<NELEM; j++)
+        src[j] = mype + j;
+    shmemx_putmem_signal(heap_buf, src, NELEM*sizeof(long), &sig, NITER+1, SHMEMX_SIGNAL_SET, next);
+    shmemx_signal_wait_until(&sig, SHMEM_CMP_EQ, NITER+1);
+    for (int j=0; j<NELEM; j++)
+        assert(heap_buf[j]==prev + j);
+
+    shmem_barrier_all();
+
+    shfree(heap_buf);
+    shfree(heap_sig);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+#else
+    printf("put signal extension is not enabled\n");
+    return 77;
+#endif
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <shmem.h>
+
+#define CHUNK 4000 /* bytes, not a multiple of sizeof(double) */
+#define NBYTE (64*CHUNK)
+
+/* Global, so that the transfers go through MPI even on one node. */
+char   bytes[NBYTE+1];
+double doubles[NBYTE/sizeof(double)+1];
+
+static const size_t lengths[] = { 1, CHUNK-1, CHUNK, CHUNK+1, 3*CHUNK, 3*CHUNK+7, NBYTE-5, NBYTE };
+
+int main(void)
+{
+    /* Both are read in start_pes, so they have to be set before. */
+    setenv("OSHMPI_RMA_CHUNK_SIZE", "4000", 1);
+    setenv("OSHMPI_RMA_CHUNK_DEPTH", "3", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    char * src = malloc(NBYTE);
+    char * dst = malloc(NBYTE+1);
+    for (size_t i=0; i<NBYTE; i++)
+        src[i] = (char)(mype+i);
+
+    /* Lengths at and around chunk boundaries, so the last chunk is short,
+     * full, or a single byte, and the byte past the end is not written. */
+    for (size_t k=0; k<sizeof(lengths)/sizeof(lengths[0]); k++) {
+        size_t len = lengths[k];
+
+        memset(bytes, -1, sizeof(bytes));
+        shmem_barrier_all();
+        shmem_putmem(bytes, src, len, next);
+        shmem_barrier_all();
+        for (size_t i=0; i<len; i++)
+            assert(bytes[i]==(char)(prev+i));
+        assert(bytes[len]==(char)-1);
+
+        memset(dst, -1, NBYTE+1);
+        shmem_getmem(dst, bytes, len, next);
+        assert(memcmp(dst, src, len)==0);
+        assert(dst[len]==(char)-1);
+        shmem_barrier_all();
+    }
+
+    /* A chunk that does not hold a whole number of elements is rounded
+     * down, so no element is split between two operations. */
+    const size_t ndouble = NBYTE/sizeof(double);
+    double * dsrc = malloc(ndouble*sizeof(double));
+    for (size_t i=0; i<ndouble; i++) {
+        dsrc[i] = (double)(mype*ndouble + i);
+        doubles[i] = -1.0;
+    }
+    doubles[ndouble] = -1.0;
+    shmem_barrier_all();
+
+    shmem_double_put(doubles, dsrc, ndouble, next);
+    /* the source may be reused once the put returns, even if chunked */
+    memset(dsrc, 0, ndouble*sizeof(double));
+    shmem_barrier_all();
+    for (size_t i=0; i<ndouble; i++)
+        assert(doubles[i]==(double)(prev*ndouble + i));
+    assert(doubles[ndouble]==-1.0);
+
+    shmem_double_get(dsrc, doubles, ndouble, next);
+    for (size_t i=0; i<ndouble; i++)
+        assert(dsrc[i]==(double)(mype*ndouble + i));
+
+    shmem_barrier_all();
+
+    free(dsrc);
+    free(dst);
+    free(src);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <shmem.h>
+
+#define NOPS  2000
+#define NLIVE 64
+#define DEPTH 4
+
+static long offsets[NOPS];
+
+int main(void)
+{
+    /* A heap that the cache could fill, and small magazines that overflow.
+     * They are read in start_pes, so they have to be set before. */
+    setenv("SHMEM_SYMMETRIC_HEAP_SIZE", "8M", 1);
+    setenv("OSHMPI_SHEAP_CACHE_DEPTH", "4", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    char * anchor = shmalloc(1);
+
+    /* A freed block comes back for any request in its size class,
+     * and the magazine is LIFO. */
+    void * a = shmalloc(1000);
+    void * b = shmalloc(1000);
+    shfree(a);
+    shfree(b);
+    void * p = shmalloc(1024);
+    assert(p==b);
+    p = shmalloc(999);
+    assert(p==a);
+    for (int i=0; i<100; i++) {
+        shfree(a);
+        p = shmalloc(1000);
+        assert(p==a);
+    }
+    shfree(a);
+    shfree(b);
+
+    /* A full magazine keeps the blocks freed last. */
+    void * blocks[2*DEPTH];
+    for (int i=0; i<2*DEPTH; i++)
+        blocks[i] = shmalloc(200);
+    for (int i=0; i<2*DEPTH; i++)
+        shfree(blocks[i]);
+    p = shmalloc(200);
+    assert(p==blocks[2*DEPTH-1]);
+    shfree(p);
+
+    /* A deterministic mix of sizes and lifetimes gives the same offsets
+     * on every PE. */
+    void * live[NLIVE] = { NULL };
+    unsigned seed = 12345;
+    int nops = 0;
+    for (int i=0; i<NOPS; i++) {
+        seed = seed*1103515245u + 12345u;
+        int slot = (seed>>8) % NLIVE;
+        if (live[slot]!=NULL) {
+            shfree(live[slot]);
+            live[slot] = NULL;
+        } else {
+            size_t size = 1 + (seed>>16) % (((seed>>4)&3)==0 ? 200000 : 4096);
+            live[slot] = shmalloc(size);
+            assert(live[slot]!=NULL);
+            memset(live[slot], 0, size);
+            offsets[nops++] = (long)((intptr_t)live[slot]-(intptr_t)anchor);
+        }
+    }
+    shmem_barrier_all();
+
+    long * theirs = malloc(NOPS*sizeof(long));
+    shmem_long_get(theirs, offsets, nops, next);
+    assert(memcmp(theirs, offsets, nops*sizeof(long))==0);
+    free(theirs);
+
+    for (int i=0; i<NLIVE; i++)
+        if (live[i]!=NULL) shmem_char_p(live[i], (char)mype, next);
+    shmem_barrier_all();
+    for (int i=0; i<NLIVE; i++) {
+        if (live[i]!=NULL) assert(*(char*)live[i]==(char)prev);
+        shfree(live[i]);
+    }
+
+    /* Cached blocks must not make the heap look full to shmalloc... */
+    void * big = shmalloc(7000000);
+    assert(big!=NULL);
+    shfree(big);
+
+    /* ...nor to shrealloc. */
+    void * cached[DEPTH];
+    for (int c=1<<10; c<=1<<16; c<<=1) {
+        for (int i=0; i<DEPTH; i++) cached[i] = shmalloc(c);
+        for (int i=0; i<DEPTH; i++) shfree(cached[i]);
+    }
+    big = shrealloc(shmalloc(100), 7700000);
+    assert(big!=NULL);
+    shfree(big);
+
+    shfree(anchor);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
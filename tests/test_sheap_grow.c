@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <shmem.h>
+
+#define HEAP    (4<<20)
+#define NBLOCKS 6
+#define NBYTES  (3<<20) /* larger than a segment */
+
+int main(void)
+{
+    /* A heap that holds one block, growing by segments smaller than a
+     * block.  They are read in start_pes, so they have to be set before. */
+    setenv("SHMEM_SYMMETRIC_HEAP_SIZE", "4M", 1);
+    setenv("OSHMPI_SHEAP_GROWABLE", "1", 1);
+    setenv("OSHMPI_SHEAP_SEGMENT_SIZE", "2M", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    long * first = shmalloc(sizeof(long));
+    assert(first!=NULL);
+
+    char * blocks[NBLOCKS];
+    long * counters[NBLOCKS];
+    int outside = 0;
+    for (int b=0; b<NBLOCKS; b++) {
+        blocks[b]   = shmalloc(NBYTES);
+        counters[b] = shmemalign(64, sizeof(long));
+        assert(blocks[b]!=NULL && counters[b]!=NULL);
+        assert(((uintptr_t)counters[b] & 63)==0);
+        *counters[b] = 0;
+
+        /* every block is symmetric, wherever it was placed */
+        assert(shmem_addr_accessible(blocks[b], next));
+        assert(shmem_addr_accessible(blocks[b]+NBYTES-1, next));
+        /* the initial heap holds first, so a block in it is within HEAP of it */
+        intptr_t d = (intptr_t)blocks[b] - (intptr_t)first;
+        if (d<=-HEAP || d+NBYTES>=HEAP) outside++;
+    }
+    /* about 18M do not fit in 4M, so most blocks are in added segments */
+    assert(outside>=NBLOCKS-1);
+    shmem_barrier_all();
+
+    char * src = malloc(NBYTES);
+    for (int b=0; b<NBLOCKS; b++) {
+        memset(src, (char)(mype+b), NBYTES);
+        shmem_putmem(blocks[b], src, NBYTES, next);
+        shmem_long_add(counters[b], b+1, next);
+        shmem_long_fadd(counters[b], 1, next);
+    }
+    shmem_barrier_all();
+
+    for (int b=0; b<NBLOCKS; b++) {
+        for (size_t i=0; i<NBYTES; i++)
+            assert(blocks[b][i]==(char)(prev+b));
+        assert(*counters[b]==b+2);
+
+        char got;
+        shmem_getmem(&got, blocks[b]+NBYTES-1, 1, next);
+        assert(got==(char)(mype+b));
+
+        char * p = shmem_ptr(blocks[b], next);
+        if (p!=NULL) assert(p[0]==(char)(mype+b));
+    }
+    shmem_barrier_all();
+
+    /* waiting on a word in an added segment */
+    long * flag = counters[NBLOCKS-1];
+    shmem_long_p(flag, -1, next);
+    shmem_long_wait_until(flag, SHMEM_CMP_EQ, -1);
+    shmem_barrier_all();
+
+    /* growing a block past any free space keeps its contents */
+    blocks[0] = shrealloc(blocks[0], 2*NBYTES);
+    assert(blocks[0]!=NULL);
+    for (size_t i=0; i<NBYTES; i++)
+        assert(blocks[0][i]==(char)(prev+0));
+
+    for (int b=NBLOCKS-1; b>=0; b--) {
+        shfree(counters[b]);
+        shfree(blocks[b]);
+    }
+
+    /* and the space can be used again */
+    char * again = shmalloc(2*NBYTES);
+    assert(again!=NULL);
+    shfree(again);
+    shfree(first);
+
+    free(src);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <shmem.h>
+
+#define NELEM (1<<20)     /* 8 MiB, so several huge pages */
+#define PAGE  (1<<21)     /* a typical huge page, in bytes */
+
+int main(void)
+{
+    /* hugetlb falls back to transparent huge pages when the pool is empty,
+     * which is the usual case.  It is read in start_pes, so it has to be set
+     * before. */
+    setenv("OSHMPI_SHEAP_HUGEPAGES", "hugetlb", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    long * a       = shmalloc(NELEM*sizeof(long));
+    long * counter = shmalloc(sizeof(long));
+    long * src     = malloc(NELEM*sizeof(long));
+    for (int i=0; i<NELEM; i++) {
+        a[i]   = -1;
+        src[i] = (long)mype*NELEM + i;
+    }
+    *counter = 0;
+    shmem_barrier_all();
+
+    /* a put that crosses huge page boundaries, and a later put to its last
+     * element, which the fence orders after it */
+    shmem_long_put(a, src, NELEM, next);
+    shmem_fence();
+    shmem_long_p(&a[NELEM-1], -2, next);
+    shmem_long_add(counter, 1, next);
+    shmem_barrier_all();
+
+    for (int i=0; i<NELEM-1; i++)
+        assert(a[i]==(long)prev*NELEM + i);
+    assert(a[NELEM-1]==-2);
+    assert(*counter==1);
+
+    long * b = malloc(NELEM*sizeof(long));
+    shmem_long_get(b, a, NELEM-1, next);
+    for (int i=0; i<NELEM-1; i++)
+        assert(b[i]==src[i]);
+    free(b);
+    shmem_barrier_all();
+
+    /* The heaps of the other PEs on the node are mapped here, not by MPI,
+     * so stores through shmem_ptr must land in the same pages. */
+    assert(shmem_ptr(a, mype)==a);
+    long * p = shmem_ptr(a, next);
+    if (p!=NULL) {
+        for (size_t i=0; i<NELEM; i+=PAGE/sizeof(long))
+            p[i] = mype;
+    }
+    shmem_barrier_all();
+    if (shmem_ptr(a, prev)!=NULL) {
+        for (size_t i=0; i<NELEM; i+=PAGE/sizeof(long))
+            assert(a[i]==prev);
+    }
+
+    shmem_barrier_all();
+
+    free(src);
+    shfree(counter);
+    shfree(a);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
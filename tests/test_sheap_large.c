@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <shmem.h>
+
+#define MB     (1024*1024)
+#define NBLOCK 8
+
+static long offsets[NBLOCK];
+
+int main(void)
+{
+    /* A 32M zone at the top of a 64M heap.  They are read in start_pes, so
+     * they have to be set before. */
+    setenv("SHMEM_SYMMETRIC_HEAP_SIZE", "64M", 1);
+    setenv("OSHMPI_SHEAP_LARGE_THRESHOLD", "1M", 1);
+    setenv("OSHMPI_SHEAP_LARGE_ZONE", "32M", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+
+    char * anchor = shmalloc(1);
+
+    /* Large blocks are whole pages, allocated from the top of the zone
+     * down, above everything dlmalloc hands out. */
+    const size_t sizes[NBLOCK] = { 1*MB, 3*MB+5, 2*MB, 1*MB+4097, 4*MB, 2*MB-1, 5*MB, 1*MB };
+    char * big[NBLOCK];
+    char * small[NBLOCK];
+    for (int i=0; i<NBLOCK; i++) {
+        big[i]   = shmalloc(sizes[i]);
+        small[i] = shmalloc(100+i);
+        assert(big[i]!=NULL && small[i]!=NULL);
+        assert((uintptr_t)big[i] % page == 0);
+        if (i>0) assert(big[i]+sizes[i] <= big[i-1]);
+        offsets[i] = (long)(big[i]-anchor);
+    }
+    char * top = big[0] + sizes[0];
+    for (int i=0; i<NBLOCK; i++)
+        assert(small[i]+100+i <= big[NBLOCK-1]);
+
+    /* the offsets agree with the neighbour's */
+    shmem_barrier_all();
+    long theirs[NBLOCK];
+    shmem_long_get(theirs, offsets, NBLOCK, next);
+    assert(memcmp(theirs, offsets, sizeof(offsets))==0);
+
+    /* the ends of each block in particular, next to small blocks */
+    for (int i=0; i<NBLOCK; i++) {
+        shmem_char_p(&big[i][0], (char)(mype+i), next);
+        shmem_char_p(&big[i][sizes[i]-1], (char)(mype-i), next);
+        memset(small[i], mype, 100+i);
+    }
+    shmem_barrier_all();
+    for (int i=0; i<NBLOCK; i++) {
+        assert(big[i][0]==(char)(prev+i));
+        assert(big[i][sizes[i]-1]==(char)(prev-i));
+        for (int j=0; j<100+i; j++)
+            assert(small[i][j]==(char)mype);
+    }
+    shmem_barrier_all();
+
+    /* neighbours coalesce: 3M+5, 2M and 1M+4097 make room for 6M */
+    shfree(big[1]);
+    shfree(big[2]);
+    shfree(big[3]);
+    big[1] = shmalloc(6*MB);
+    big[2] = big[3] = NULL;
+    assert(big[1]!=NULL && (uintptr_t)big[1] % page == 0);
+
+    /* shrinking keeps the block, growing moves it with its contents */
+    char * r = shrealloc(big[4], 3*MB);
+    assert(r==big[4]);
+    r[0] = 42;
+    r = shrealloc(r, 7*MB);
+    assert(r!=NULL && r[0]==42);
+    big[4] = r;
+
+    /* what the zone cannot hold comes from dlmalloc, below it */
+    char * huge = shmalloc(24*MB);
+    assert(huge!=NULL);
+    for (int i=0; i<NBLOCK; i++)
+        if (big[i]!=NULL) assert(huge+24*MB <= big[i]);
+    shfree(huge);
+
+    for (int i=0; i<NBLOCK; i++) {
+        shfree(big[i]);
+        shfree(small[i]);
+    }
+
+    /* and all of the zone is one free extent again, so a block of almost
+     * its size goes at its top, give or take a huge page of alignment */
+    huge = shmalloc(30*MB);
+    assert(huge!=NULL && (uintptr_t)huge % page == 0);
+    assert(huge+30*MB <= top && huge+30*MB+2*MB > top);
+    shfree(huge);
+    shfree(anchor);
+
+    shmem_barrier_all();
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
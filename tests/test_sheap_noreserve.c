@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <shmem.h>
+
+#define NBYTES (8<<20)
+
+/* resident set of this process, in bytes */
+static long resident(void)
+{
+    long size = 0, rss = 0;
+    FILE * f = fopen("/proc/self/statm", "r");
+    if (f==NULL) return -1;
+    if (fscanf(f, "%ld %ld", &size, &rss)!=2) rss = -1;
+    fclose(f);
+    return (rss<0) ? -1 : rss*sysconf(_SC_PAGESIZE);
+}
+
+int main(void)
+{
+    /* Both are read in start_pes, so they have to be set before. */
+    setenv("OSHMPI_SHEAP_NORESERVE", "1", 1);
+    setenv("OSHMPI_SHEAP_RELEASE_THRESHOLD", "1000000", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    char * src = malloc(NBYTES);
+
+    for (int iter=0; iter<4; iter++) {
+        /* small blocks on both sides of the large ones, which must survive
+         * the release of the pages in between */
+        long * small1 = shmalloc(sizeof(long));
+        char * big1   = shmalloc(NBYTES);
+        long * small2 = shmalloc(sizeof(long));
+        char * big2   = shmalloc(NBYTES/2+12345);
+        *small1 = *small2 = mype+iter;
+
+        /* a block whose pages were released reads and writes as usual */
+        memset(src, (char)(mype+iter), NBYTES);
+        shmem_barrier_all();
+        shmem_putmem(big1, src, NBYTES, next);
+        shmem_putmem(big2, src, NBYTES/2+12345, next);
+        shmem_barrier_all();
+
+        for (size_t i=0; i<NBYTES; i++)
+            assert(big1[i]==(char)(prev+iter));
+        for (size_t i=0; i<NBYTES/2+12345; i++)
+            assert(big2[i]==(char)(prev+iter));
+        assert(shmem_long_g(small1, next)==next+iter);
+        shmem_barrier_all();
+
+        /* Pages are only released when the heap is shared memory on one
+         * node; then freeing a block that this PE touched shrinks it. */
+        int released = (npes>1 && shmem_ptr(big1, next)!=NULL);
+        memset(big1, 0, NBYTES);
+        long before = resident();
+        shfree(big1);
+        long after = resident();
+        if (released && before>0 && after>0)
+            assert(before-after >= NBYTES/2);
+
+        assert(*small1==mype+iter && *small2==mype+iter);
+        shfree(big2);
+        assert(*small1==mype+iter && *small2==mype+iter);
+        shfree(small2);
+        shfree(small1);
+    }
+
+    shmem_barrier_all();
+
+    free(src);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define NELEM 100000
+#define NITER 1000
+
+int main(void)
+{
+#if EXTENSION_SPACE
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    shmemx_space_t bulk     = shmemx_space_create(NELEM*sizeof(double), SHMEMX_SPACE_UNORDERED|SHMEMX_SPACE_HUGEPAGES);
+    shmemx_space_t flags    = shmemx_space_create(4096, SHMEMX_SPACE_ATOMICS_ONLY);
+    shmemx_space_t counters = shmemx_space_create(4096, SHMEMX_SPACE_SAME_OP);
+    assert(bulk!=NULL && flags!=NULL && counters!=NULL);
+
+    double * a    = shmemx_space_malloc(bulk, NELEM*sizeof(double));
+    long *   flag = shmemx_space_align(flags, 64, 2*sizeof(long));
+    long *   ctr  = shmemx_space_malloc(counters, sizeof(long));
+    assert(a!=NULL && flag!=NULL && ctr!=NULL);
+    assert(((uintptr_t)flag & 63)==0);
+    assert(shmem_addr_accessible(a+NELEM-1, next));
+    assert(shmem_addr_accessible(flag, next));
+
+    /* a space does not grow */
+    void * full = shmemx_space_malloc(flags, 8192);
+    assert(full==NULL);
+
+    double * src = malloc(NELEM*sizeof(double));
+    for (int i=0; i<NELEM; i++) src[i] = mype + 1.e-6*i;
+    flag[0] = flag[1] = 0;
+    *ctr = 0;
+    shmem_barrier_all();
+
+    /* bulk data, then a flag, in spaces with different ordering hints */
+    shmem_double_put(a, src, NELEM, next);
+    shmem_fence();
+    shmem_long_p(flag, 1, next);
+    shmem_long_wait_until(flag, SHMEM_CMP_GE, 1);
+    for (int i=0; i<NELEM; i++)
+        assert(a[i]==prev + 1.e-6*i);
+    shmem_barrier_all();
+
+    /* In an atomics-only space a get is atomic with respect to the adds
+     * on the same word, so the neighbour's count never goes backwards.
+     * It may be anywhere in both loops below, which have no barrier. */
+    long seen = 0;
+    for (int i=0; i<NITER; i++) {
+        shmem_long_add(&flag[1], 1, next);
+        long v = shmem_long_g(&flag[1], prev);
+        assert(v>=seen && v<=2*NITER);
+        seen = v;
+    }
+#if EXTENSION_SYM_HANDLE
+    /* the same holds through a handle */
+    shmemx_sym_handle_t h = shmemx_resolve(&flag[1]);
+    for (int i=0; i<NITER; i++) {
+        shmemx_long_atomic_add_h(h, 0, 1, next);
+        long v;
+        shmemx_get_h(&v, h, 0, sizeof(long), prev);
+        assert(v>=seen && v<=2*NITER);
+        seen = v;
+    }
+#endif
+    shmem_barrier_all();
+
+    /* same_op: only add and fadd on the counters */
+    for (int pe=0; pe<npes; pe++)
+        shmem_long_add(ctr, 1, pe);
+    shmem_barrier_all();
+    assert(*ctr==npes);
+
+    long old = shmem_long_swap(flag, 2, next);
+    assert(old==1);
+    shmem_barrier_all();
+    assert(*flag==2);
+    double * p = shmem_ptr(a, next);
+    if (p!=NULL) assert(p[1]==mype + 1.e-6);
+    shmem_barrier_all();
+
+    /* the flags space goes away, the others are still there */
+    shfree(flag);
+    shmemx_space_destroy(flags);
+    shmem_double_get(src, a, NELEM, next);
+    for (int i=0; i<NELEM; i++)
+        assert(src[i]==mype + 1.e-6*i);
+    old = shmem_long_fadd(ctr, 1, next);
+    assert(old==npes);
+    shmem_barrier_all();
+    assert(*ctr==npes+1);
+
+    shfree(ctr);
+    shfree(a);
+    shmemx_space_destroy(counters);
+    shmemx_space_destroy(bulk);
+
+    free(src);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+#else
+    printf("space extension is not enabled\n");
+    return 77;
+#endif
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <assert.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define NELEM 1000
+
+long global_counter = 0;
+
+int main(void)
+{
+#if EXTENSION_SYM_HANDLE
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    long * buf = shmalloc(NELEM*sizeof(long));
+    long * ctr = shmalloc(sizeof(long));
+    for (int i=0; i<NELEM; i++) buf[i] = -1;
+    *ctr = 0;
+
+    shmemx_sym_handle_t hb = shmemx_resolve(buf);
+    shmemx_sym_handle_t hc = shmemx_resolve(ctr);
+    shmemx_sym_handle_t hg = shmemx_resolve(&global_counter);
+
+    shmem_barrier_all();
+
+    /* element-wise puts through the handle, one offset at a time */
+    for (int i=0; i<NELEM; i++) {
+        long v = mype*NELEM+i;
+        shmemx_put_h(hb, i*sizeof(long), &v, sizeof(long), next);
+    }
+
+    shmem_barrier_all();
+
+    for (int i=0; i<NELEM; i++)
+        assert(buf[i] == prev*NELEM+i);
+
+    long tmp[NELEM];
+    shmemx_get_h(tmp, hb, 0, NELEM*sizeof(long), next);
+    for (int i=0; i<NELEM; i++)
+        assert(tmp[i] == mype*NELEM+i);
+
+    /* atomics on the heap and on global data */
+    for (int i=0; i<NELEM; i++) {
+        shmemx_long_atomic_add_h(hc, 0, 1, 0);
+        shmemx_long_atomic_fadd_h(hg, 0, 1, 0);
+    }
+
+    shmem_barrier_all();
+
+    if (mype==0) {
+        assert(*ctr == (long)npes*NELEM);
+        assert(global_counter == (long)npes*NELEM);
+    }
+
+    shmem_barrier_all();
+
+    *ctr = mype;
+
+    shmem_barrier_all();
+
+    long old = shmemx_long_atomic_swap_h(hc, 0, -1, next);
+    assert(old == next);
+    old = shmemx_long_atomic_cswap_h(hc, 0, -1, 42, next);
+    assert(old == -1);
+    long now;
+    shmemx_get_h(&now, hc, 0, sizeof(long), next);
+    assert(now == 42);
+
+    shmem_barrier_all();
+
+    shfree(ctr);
+    shfree(buf);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+#else
+    printf("symmetric handle extension is not enabled\n");
+    return 77;
+#endif
+}
@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <shmem.h>
+#include <shmemx.h>
+
+#define NELEM (1<<17)
+
+int my_domain = -2;
+
+int main(void)
+{
+#if EXTENSION_TOPOLOGY
+    /* It is read in start_pes, so it has to be set before. */
+    setenv("OSHMPI_BIND", "numa", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+
+    int ndomains = shmemx_num_numa_domains();
+    assert(ndomains>=1);
+
+    my_domain = shmemx_pe_numa_domain(mype);
+    assert(0<=my_domain && my_domain<ndomains);
+    assert(shmemx_pe_numa_domain(-1)==-1);
+    assert(shmemx_pe_numa_domain(npes)==-1);
+
+    shmem_barrier_all();
+
+    /* The table every PE gathered agrees with what each PE says about
+     * itself.  PEs on other nodes are -1.  PEs on this node are bound in
+     * blocks of consecutive ranks, so their domains never decrease. */
+    int last = 0;
+    for (int pe=0; pe<npes; pe++) {
+        int d = shmemx_pe_numa_domain(pe);
+        if (d<0) continue;
+        assert(d==shmem_int_g(&my_domain, pe));
+        assert(d>=last);
+        last = d;
+    }
+
+    /* the heap segment of each PE is bound to its domain, and still
+     * readable by the others */
+    long * x = shmalloc(NELEM*sizeof(long));
+    for (int i=0; i<NELEM; i++)
+        x[i] = (long)mype*NELEM + i;
+    shmem_barrier_all();
+
+    int next = (mype+1)%npes;
+    long * y = malloc(NELEM*sizeof(long));
+    shmem_long_get(y, x, NELEM, next);
+    for (int i=0; i<NELEM; i++)
+        assert(y[i]==(long)next*NELEM + i);
+    free(y);
+
+    shmem_barrier_all();
+
+    shfree(x);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+#else
+    printf("topology extension is not enabled\n");
+    return 77;
+#endif
+}
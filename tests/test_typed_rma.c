@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <assert.h>
+#include <complex.h>
+#include <shmem.h>
+
+#define NELEM 64
+
+double global_double = 0.0;
+
+int main(void)
+{
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+    int prev = (mype+npes-1)%npes;
+
+    char   * c = shmalloc(2*NELEM*sizeof(char));
+    short  * s = shmalloc(2*NELEM*sizeof(short));
+    double * d = shmalloc(2*NELEM*sizeof(double));
+    double complex * z = shmalloc(NELEM*sizeof(double complex));
+    float  * f = shmalloc(sizeof(float));
+    for (int i=0; i<2*NELEM; i++) {
+        c[i] = 0;
+        s[i] = -1;
+        d[i] = -1.0;
+    }
+    for (int i=0; i<NELEM; i++) z[i] = 0.0;
+    *f = (float)mype;
+    global_double = (double)mype;
+
+    char   cs[NELEM];
+    short  ss[NELEM];
+    double ds[NELEM];
+    double complex zs[NELEM];
+    for (int i=0; i<NELEM; i++) {
+        cs[i] = (char)(mype+i);
+        ss[i] = (short)(mype*NELEM+i);
+        ds[i] = 0.25*i+mype;
+        zs[i] = i + I*mype;
+    }
+
+    shmem_barrier_all();
+
+    /* strided puts scatter into every other element */
+    shmem_char_iput(c, cs, 2, 1, NELEM, next);
+    shmem_short_iput(s, ss, 2, 1, NELEM, next);
+    shmem_iput64(d, ds, 2, 1, NELEM, next);
+    shmem_complexd_put(z, zs, NELEM, next);
+
+    shmem_barrier_all();
+
+    for (int i=0; i<NELEM; i++) {
+        assert(c[2*i] == (char)(prev+i) && c[2*i+1] == 0);
+        assert(s[2*i] == (short)(prev*NELEM+i) && s[2*i+1] == -1);
+        assert(d[2*i] == 0.25*i+prev && d[2*i+1] == -1.0);
+        assert(z[i] == i + I*prev);
+    }
+
+    /* strided get gathers them back */
+    short sg[NELEM];
+    double dg[NELEM];
+    shmem_short_iget(sg, s, 1, 2, NELEM, next);
+    shmem_double_iget(dg, d, 1, 2, NELEM, next);
+    for (int i=0; i<NELEM; i++) {
+        assert(sg[i] == ss[i]);
+        assert(dg[i] == ds[i]);
+    }
+
+    double complex zg[NELEM];
+    shmem_get128(zg, z, NELEM, next);
+    for (int i=0; i<NELEM; i++)
+        assert(zg[i] == zs[i]);
+
+    shmem_barrier_all();
+
+    /* floating-point swap on the heap and on global data */
+    float fold = shmem_float_swap(f, 0.5f+mype, next);
+    assert(fold == (float)next);
+    double dold = shmem_double_swap(&global_double, 0.5+mype, next);
+    assert(dold == (double)next);
+
+    shmem_barrier_all();
+
+    assert(*f == 0.5f+prev);
+    assert(global_double == 0.5+prev);
+
+    shmem_barrier_all();
+
+    shfree(f);
+    shfree(z);
+    shfree(d);
+    shfree(s);
+    shfree(c);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <shmem.h>
+
+#define NITER 1000
+
+static const char * policies[] = { "spin", "yield", "block", "adaptive" };
+
+int main(int argc, char * argv[])
+{
+    /* The policy is read in start_pes, so it has to be set before. */
+    int policy = (argc>1) ? atoi(argv[1]) : 2;
+    setenv("OSHMPI_WAIT_POLICY", policies[policy%4], 1);
+    setenv("OSHMPI_WAIT_STATS", "1", 1);
+
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+
+    long * flag = shmalloc(sizeof(long));
+    *flag = 0;
+
+    shmem_barrier_all();
+
+    /* token ring: every PE but the first waits for its predecessor */
+    for (long i=1; i<=NITER; i++) {
+        if (mype==0) {
+            shmem_long_p(flag, i, next);
+            shmem_long_wait_until(flag, SHMEM_CMP_GE, i);
+        } else {
+            shmem_long_wait_until(flag, SHMEM_CMP_GE, i);
+            shmem_long_p(flag, i, next);
+        }
+    }
+    assert(*flag==NITER);
+
+    shmem_barrier_all();
+
+    shfree(flag);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include <shmem.h>
+
+#define NFLAGS 16
+
+int main(void)
+{
+    start_pes(0);
+
+    int mype = shmem_my_pe();
+    int npes = shmem_n_pes();
+    int next = (mype+1)%npes;
+
+    long * flags = shmalloc(NFLAGS*sizeof(long));
+    int  * iflags = shmalloc(NFLAGS*sizeof(int));
+    int status[NFLAGS];
+    size_t indices[NFLAGS];
+
+    for (int i=0; i<NFLAGS; i++) {
+        flags[i]  = 0;
+        iflags[i] = 0;
+        status[i] = 0;
+    }
+
+    shmem_barrier_all();
+
+    assert(shmem_long_test(&flags[0], SHMEM_CMP_EQ, 0));
+    assert(!shmem_long_test(&flags[0], SHMEM_CMP_NE, 0));
+
+    /* all elements excluded */
+    for (int i=0; i<NFLAGS; i++) status[i] = 1;
+    assert(shmem_long_wait_until_any(flags, NFLAGS, status, SHMEM_CMP_NE, 0) == SIZE_MAX);
+    assert(shmem_long_wait_until_some(flags, NFLAGS, indices, status, SHMEM_CMP_NE, 0) == 0);
+    for (int i=0; i<NFLAGS; i++) status[i] = 0;
+
+    shmem_barrier_all();
+
+    /* flags are set in reverse order and consumed in whatever order they arrive */
+    for (int i=NFLAGS-1; i>=0; i--) {
+        shmem_long_p(&flags[i], i+1, next);
+        shmem_quiet();
+    }
+
+    for (int n=0; n<NFLAGS; n++) {
+        size_t i = shmem_long_wait_until_any(flags, NFLAGS, status, SHMEM_CMP_NE, 0);
+        assert(i<NFLAGS);
+        assert(status[i]==0);
+        assert(flags[i]==(long)i+1);
+        status[i] = 1;
+    }
+    for (int i=0; i<NFLAGS; i++)
+        assert(shmem_long_test(&flags[i], SHMEM_CMP_GT, 0));
+
+    shmem_barrier_all();
+
+    for (int i=0; i<NFLAGS; i++) status[i] = 0;
+    for (int i=0; i<NFLAGS; i++) {
+        shmem_int_p(&iflags[i], 1, next);
+        shmem_quiet();
+    }
+
+    size_t nseen = 0;
+    while (nseen<NFLAGS) {
+        size_t n = shmem_int_wait_until_some(iflags, NFLAGS, indices, status, SHMEM_CMP_EQ, 1);
+        assert(n>0);
+        for (size_t j=0; j<n; j++) {
+            assert(status[indices[j]]==0);
+            status[indices[j]] = 1;
+        }
+        nseen += n;
+    }
+
+    shmem_int_wait_until_all(iflags, NFLAGS, NULL, SHMEM_CMP_EQ, 1);
+
+    shmem_barrier_all();
+
+    shfree(iflags);
+    shfree(flags);
+
+    if (mype==0) printf("SUCCESS\n");
+
+    return 0;
+}